@@ -3,7 +3,9 @@
 
 #include <glm/glm.hpp>
 
+#include <cstddef>
 #include <limits>
+#include <span>
 
 class AABB
 {
@@ -19,17 +21,49 @@ public:
 	{
 		Ray::time_t m_time;
 		glm::vec3 m_point;
-		Axis m_axis;
+		Axis m_axis; // Axis of the slab the ray entered last
 	};
 
+	// Boxes or rays in structure-of-arrays layout, one span per coordinate
+	struct Boxes
+	{
+		std::span<const float> m_minX, m_minY, m_minZ;
+		std::span<const float> m_maxX, m_maxY, m_maxZ;
+	};
+
+	struct Rays
+	{
+		std::span<const float> m_originX, m_originY, m_originZ;
+		std::span<const float> m_directionX, m_directionY, m_directionZ;
+	};
+
+	// Kernels behind the batch tests; BestPath is what the running CPU supports
+	enum class Path { Scalar, SSE41, AVX };
+	static Path BestPath();
+
 	AABB(const glm::vec3 &min, const glm::vec3 &max);
 
 	glm::vec3 Max() const { return m_max; }
 	glm::vec3 Min() const { return m_min; }
 
+	// Slab test: the ray hits when it is inside the box at some time in
+	// [minTime, maxTime]; the record holds the first such time. A ray with a
+	// NaN coordinate never hits.
 	Ray::HitType Hit(const Ray &ray, Ray::time_t minTime, Ray::time_t maxTime, HitRecord &record) const;
+	// Narrows [minTime, maxTime] to the part of the ray inside the box
+	bool Clip(const Ray &ray, Ray::time_t &minTime, Ray::time_t &maxTime) const;
+
+	// One ray against boxes.m_minX.size() boxes (or rays.m_originX.size() rays
+	// against this box): times[i] is the entry time of hit i, infinity on a
+	// miss. Returns the number of hits. 4 (SSE4.1) or 8 (AVX) tests at a
+	// time; every path gives the same results as Hit. Every span of boxes or
+	// rays must be as long as times, otherwise nothing is tested and 0 returned.
+	static size_t Hit(const Ray &ray, Ray::time_t minTime, Ray::time_t maxTime, const Boxes &boxes, std::span<Ray::time_t> times);
+	static size_t Hit(const Ray &ray, Ray::time_t minTime, Ray::time_t maxTime, const Boxes &boxes, std::span<Ray::time_t> times, Path path);
+	size_t Hit(const Rays &rays, Ray::time_t minTime, Ray::time_t maxTime, std::span<Ray::time_t> times) const;
+	size_t Hit(const Rays &rays, Ray::time_t minTime, Ray::time_t maxTime, std::span<Ray::time_t> times, Path path) const;
 
 private:
 	glm::vec3 m_min{std::numeric_limits<float>::max()};
 	glm::vec3 m_max{std::numeric_limits<float>::min()};
-};
\ No newline at end of file
+};
@@ -0,0 +1,237 @@
+#pragma once
+#include "Cube.hpp"
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Block types of a chunk split into SectionCount sections of SectionSize
+// consecutive blocks. A section holding a single type is just that value;
+// a mixed one keeps a small local palette and packs palette indices into
+// 1, 2, 4 or 8 bits per block. Set grows the encoding as needed and, when
+// the last block of a type leaves a section, drops that type from the
+// palette and narrows the encoding again, back to a single value once one
+// type is left. Assign picks the smallest one for a whole chunk.
+template <size_t SectionSize, size_t SectionCount>
+class BlockStorage
+{
+	static_assert(SectionSize <= UINT16_MAX, "block counts of a section are 16 bit");
+
+public:
+	static constexpr size_t s_sectionSize = SectionSize;
+	static constexpr size_t s_sectionCount = SectionCount;
+	static constexpr size_t s_size = SectionSize * SectionCount;
+	using FlattenData_t = std::array<Cube::Type, s_size>;
+
+	Cube::Type Get(size_t index) const { return m_sections[index / SectionSize].Get(index % SectionSize); }
+	void Set(size_t index, Cube::Type type) { m_sections[index / SectionSize].Set(index % SectionSize, type); }
+	void Fill(Cube::Type type);
+	void Assign(std::span<const Cube::Type, s_size> data);
+
+	bool IsUniform(size_t section) const { return m_sections[section].IsUniform(); }
+	size_t UniformSectionCount() const;
+	// Bytes held by this storage, heap included
+	size_t MemoryUsage() const;
+
+private:
+	class Section
+	{
+	public:
+		Cube::Type Get(size_t index) const;
+		void Set(size_t index, Cube::Type type);
+		void Fill(Cube::Type type);
+		void Assign(const Cube::Type *data);
+
+		bool IsUniform() const { return m_bits == 0; }
+		size_t MemoryUsage() const { return sizeof(Section) + m_words.capacity() * sizeof(uint64_t); }
+
+	private:
+		std::vector<uint64_t> m_words; // Palette indices, empty when uniform
+		std::array<Cube::Type, Cube::s_typeCount> m_palette{}; // Starts as uniform air
+		std::array<uint16_t, Cube::s_typeCount> m_counts{SectionSize}; // Blocks per palette entry
+		uint8_t m_paletteSize{1};
+		uint8_t m_bits{0};
+
+		uint8_t Entry(size_t index) const;
+		void SetEntry(size_t index, uint8_t entry);
+		void Repack(uint8_t bits);
+		void Drop(uint8_t entry);
+	};
+
+	std::array<Section, SectionCount> m_sections;
+};
+
+template <size_t SectionSize, size_t SectionCount>
+inline void BlockStorage<SectionSize, SectionCount>::Fill(Cube::Type type)
+{
+	for (Section &section : m_sections)
+		section.Fill(type);
+}
+
+template <size_t SectionSize, size_t SectionCount>
+inline void BlockStorage<SectionSize, SectionCount>::Assign(std::span<const Cube::Type, s_size> data)
+{
+	for (size_t i = 0; i < SectionCount; ++i)
+		m_sections[i].Assign(data.data() + i * SectionSize);
+}
+
+template <size_t SectionSize, size_t SectionCount>
+inline size_t BlockStorage<SectionSize, SectionCount>::UniformSectionCount() const
+{
+	size_t count = 0;
+	for (const Section &section : m_sections)
+		count += section.IsUniform() ? 1 : 0;
+	return count;
+}
+
+template <size_t SectionSize, size_t SectionCount>
+inline size_t BlockStorage<SectionSize, SectionCount>::MemoryUsage() const
+{
+	size_t bytes = sizeof(BlockStorage) - sizeof(m_sections);
+	for (const Section &section : m_sections)
+		bytes += section.MemoryUsage();
+	return bytes;
+}
+
+template <size_t SectionSize, size_t SectionCount>
+inline Cube::Type BlockStorage<SectionSize, SectionCount>::Section::Get(size_t index) const
+{
+	if (m_bits == 0)
+		return m_palette[0];
+	return m_palette[Entry(index)];
+}
+
+template <size_t SectionSize, size_t SectionCount>
+inline void BlockStorage<SectionSize, SectionCount>::Section::Set(size_t index, Cube::Type type)
+{
+	uint8_t entry = 0;
+	while (entry < m_paletteSize && m_palette[entry] != type)
+		++entry;
+	const uint8_t old = m_bits == 0 ? 0 : Entry(index);
+	if (entry == old)
+		return;
+
+	if (entry == m_paletteSize)
+	{
+		// Nowy typ w sekcji: poszerzamy indeksy, gdy paleta się nie mieści
+		if (m_paletteSize == (1u << m_bits))
+			Repack(m_bits == 0 ? 1 : m_bits * 2);
+		m_palette[m_paletteSize] = type;
+		m_counts[m_paletteSize++] = 0;
+	}
+
+	SetEntry(index, entry);
+	++m_counts[entry];
+	if (--m_counts[old] == 0)
+		Drop(old);
+}
+
+template <size_t SectionSize, size_t SectionCount>
+inline void BlockStorage<SectionSize, SectionCount>::Section::Fill(Cube::Type type)
+{
+	std::vector<uint64_t>().swap(m_words);
+	m_palette[0] = type;
+	m_counts[0] = SectionSize;
+	m_paletteSize = 1;
+	m_bits = 0;
+}
+
+template <size_t SectionSize, size_t SectionCount>
+inline void BlockStorage<SectionSize, SectionCount>::Section::Assign(const Cube::Type *data)
+{
+	// Paleta w kolejności pierwszego wystąpienia
+	m_paletteSize = 0;
+	std::array<uint8_t, Cube::s_typeCount> entries{};
+	m_counts.fill(0);
+	for (size_t i = 0; i < SectionSize; ++i)
+	{
+		const size_t type = static_cast<size_t>(data[i]);
+		if (entries[type] == 0)
+		{
+			m_palette[m_paletteSize++] = data[i];
+			entries[type] = m_paletteSize;
+		}
+		++m_counts[entries[type] - 1];
+	}
+
+	uint8_t bits = 0;
+	while ((1u << bits) < m_paletteSize)
+		bits = bits == 0 ? 1 : bits * 2;
+
+	m_bits = bits;
+	if (m_bits == 0)
+	{
+		std::vector<uint64_t>().swap(m_words);
+		return;
+	}
+
+	m_words.assign((SectionSize * m_bits + 63) / 64, 0);
+	m_words.shrink_to_fit();
+	for (size_t i = 0; i < SectionSize; ++i)
+		SetEntry(i, entries[static_cast<size_t>(data[i])] - 1);
+}
+
+template <size_t SectionSize, size_t SectionCount>
+inline uint8_t BlockStorage<SectionSize, SectionCount>::Section::Entry(size_t index) const
+{
+	// Szerokości są potęgami dwójki, więc wpis nigdy nie przechodzi przez granicę słowa
+	const size_t bit = index * m_bits;
+	return static_cast<uint8_t>((m_words[bit / 64] >> (bit % 64)) & ((1u << m_bits) - 1));
+}
+
+template <size_t SectionSize, size_t SectionCount>
+inline void BlockStorage<SectionSize, SectionCount>::Section::SetEntry(size_t index, uint8_t entry)
+{
+	const size_t bit = index * m_bits;
+	const uint64_t mask = (uint64_t{1} << m_bits) - 1;
+	uint64_t &word = m_words[bit / 64];
+	word = (word & ~(mask << (bit % 64))) | (static_cast<uint64_t>(entry) << (bit % 64));
+}
+
+template <size_t SectionSize, size_t SectionCount>
+inline void BlockStorage<SectionSize, SectionCount>::Section::Repack(uint8_t bits)
+{
+	std::vector<uint8_t> entries(SectionSize, 0);
+	if (m_bits != 0)
+	{
+		for (size_t i = 0; i < SectionSize; ++i)
+			entries[i] = Entry(i);
+	}
+
+	m_bits = bits;
+	m_words.assign((SectionSize * m_bits + 63) / 64, 0);
+	m_words.shrink_to_fit();
+	for (size_t i = 0; i < SectionSize; ++i)
+		SetEntry(i, entries[i]);
+}
+
+template <size_t SectionSize, size_t SectionCount>
+inline void BlockStorage<SectionSize, SectionCount>::Section::Drop(uint8_t entry)
+{
+	const uint8_t last = m_paletteSize - 1;
+	if (last == 1)
+	{
+		Fill(m_palette[1 - entry]);
+		return;
+	}
+
+	// Ostatni wpis palety zajmuje miejsce usuniętego
+	if (entry != last)
+	{
+		m_palette[entry] = m_palette[last];
+		m_counts[entry] = m_counts[last];
+		for (size_t i = 0; i < SectionSize; ++i)
+		{
+			if (Entry(i) == last)
+				SetEntry(i, entry);
+		}
+	}
+	--m_paletteSize;
+
+	uint8_t bits = m_bits;
+	while (bits > 1 && m_paletteSize <= (1u << (bits / 2)))
+		bits /= 2;
+	if (bits != m_bits)
+		Repack(bits);
+}
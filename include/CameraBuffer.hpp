@@ -0,0 +1,33 @@
+#pragma once
+#include "ShaderProgram.hpp"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// Uniform buffer behind the "Camera" block of every shader. view/projection
+// are uploaded once per frame instead of once per program. The buffer is
+// created on the first Update, so it can be constructed without a GL context.
+class CameraBuffer
+{
+public:
+  CameraBuffer() = default;
+  CameraBuffer(const CameraBuffer &) = delete;
+  CameraBuffer &operator=(const CameraBuffer &) = delete;
+  CameraBuffer(CameraBuffer &&) noexcept;
+  CameraBuffer &operator=(CameraBuffer &&) noexcept;
+  ~CameraBuffer();
+
+  void Update(const glm::mat4 &view, const glm::mat4 &projection);
+
+private:
+  // std140: two column-major mat4, no padding
+  struct Block
+  {
+    glm::mat4 m_view;
+    glm::mat4 m_projection;
+  };
+
+  GLuint m_ubo{0};
+
+  void Release();
+};
@@ -1,257 +1,726 @@
-#pragma once
-#include "Cube.hpp"
-#include "ShaderProgram.hpp"
-#include "PerlinNoise.hpp"
-#include "CubePalette.hpp"
-#include "AABB.hpp"
-#include "Ray.hpp"
-
-#include <GL/glew.h>
-#include <glm/glm.hpp>
-#include <vector>
-#include <iostream>
-
-template <uint8_t Depth, uint8_t Width, uint8_t Height>
-class Chunk
-{
-	struct CubeData
-	{
-		Cube::Type m_type{Cube::Type::None};
-		bool m_isVisible{true};
-	};
-
-	using FlattenData_t = std::array<CubeData, Depth * Width * Height>;
-
-public:
-	Chunk(const glm::vec2 &origin, CubePalette &palette);
-	inline void Generate(const PerlinNoise &rng, float worldX, float worldZ);
-	void Draw(ShaderProgram &shader) const;
-
-	struct HitRecord
-	{
-		glm::ivec3 m_cubeIndex;
-		glm::ivec3 m_neighbourIndex;
-	};
-
-	Ray::HitType Hit(const Ray &ray, Ray::time_t min, Ray::time_t max, HitRecord &record) const;
-	bool RemoveBlock(uint8_t width, uint8_t height, uint8_t depth);
-	bool PlaceBlock(uint8_t width, uint8_t height, uint8_t depth, Cube::Type type);
-	glm::vec2 getOrigin() { return m_origin; };
-
-private:
-	size_t CoordsToIndex(size_t depth, size_t width, size_t height) const;
-	void UpdateVisibility();
-
-	CubePalette &m_palette;
-	FlattenData_t m_data;
-	glm::vec2 m_origin;
-	AABB m_aabb;
-};
-
-template <uint8_t Depth, uint8_t Width, uint8_t Height>
-inline Chunk<Depth, Width, Height>::Chunk(const glm::vec2 &origin, CubePalette &palette) : m_origin(origin), m_palette(palette),
-																						   m_aabb(glm::vec3(origin.x, 0, origin.y), glm::vec3(origin.x + Width, Height, origin.y + Depth))
-{
-	m_data.fill(CubeData{Cube::Type::None, true});
-}
-
-template <uint8_t Depth, uint8_t Width, uint8_t Height>
-inline void Chunk<Depth, Width, Height>::Generate(const PerlinNoise &rng, float worldX, float worldZ)
-{
-	for (size_t x = 0; x < Width; ++x)
-	{
-		for (size_t z = 0; z < Depth; ++z)
-		{
-			float height = rng.At(glm::vec3(worldX + x, worldZ + z, 0) * 0.1f) * Height;
-			size_t maxHeight = static_cast<size_t>(height);
-			if (x > 0)
-			{
-				float leftHeight = rng.At(glm::vec3(worldX + x - 1, worldZ + z, 0) * 0.1f) * Height;
-				maxHeight = std::min(maxHeight, static_cast<size_t>(leftHeight + 1));
-			}
-			if (z > 0)
-			{
-				float frontHeight = rng.At(glm::vec3(worldX + x, worldZ + z - 1, 0) * 0.1f) * Height;
-				maxHeight = std::min(maxHeight, static_cast<size_t>(frontHeight + 1));
-			}
-
-			for (size_t y = 0; y < Height; ++y)
-			{
-				auto &cube = m_data[CoordsToIndex(z, x, y)];
-				if (y <= maxHeight)
-				{
-					cube.m_type = (y == maxHeight) ? Cube::Type::Grass : Cube::Type::Stone;
-					cube.m_isVisible = true;
-				}
-				else
-				{
-					cube.m_type = Cube::Type::None;
-					cube.m_isVisible = false;
-				}
-			}
-		}
-	}
-	UpdateVisibility();
-}
-
-template <uint8_t Depth, uint8_t Width, uint8_t Height>
-inline void Chunk<Depth, Width, Height>::Draw(ShaderProgram &shader) const
-{
-	for (size_t x = 0; x < Width; ++x)
-	{
-		for (size_t z = 0; z < Depth; ++z)
-		{
-			for (size_t y = 0; y < Height; ++y)
-			{
-				const auto &cube = m_data[CoordsToIndex(z, x, y)];
-				if (!cube.m_isVisible)
-					continue;
-
-				// Pobierz typ bloku i narysuj go
-				const Cube &cubeType = m_palette.LookUp(cube.m_type);
-				glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(m_origin.x + x, y, m_origin.y + z));
-				shader.setUniform("model", model);
-				cubeType.draw();
-			}
-		}
-	}
-}
-
-template <uint8_t Depth, uint8_t Width, uint8_t Height>
-inline size_t Chunk<Depth, Width, Height>::CoordsToIndex(size_t depth, size_t width, size_t height) const
-{
-	return height * static_cast<size_t>(Depth) * static_cast<size_t>(Width) + width * static_cast<size_t>(Depth) + depth;
-}
-
-template <uint8_t Depth, uint8_t Width, uint8_t Height>
-inline void Chunk<Depth, Width, Height>::UpdateVisibility()
-{
-	for (size_t x = 0; x < Width; ++x)
-	{
-		for (size_t z = 0; z < Depth; ++z)
-		{
-			for (size_t y = 0; y < Height; ++y)
-			{
-				auto &cube = m_data[CoordsToIndex(z, x, y)];
-				if (cube.m_type == Cube::Type::None)
-				{
-					cube.m_isVisible = false;
-					continue;
-				}
-
-				// Sprawdź sąsiednie bloki
-				bool hasVisibleNeighbor = false;
-				for (int dx = -1; dx <= 1 && !hasVisibleNeighbor; ++dx)
-				{
-					for (int dy = -1; dy <= 1 && !hasVisibleNeighbor; ++dy)
-					{
-						for (int dz = -1; dz <= 1 && !hasVisibleNeighbor; ++dz)
-						{
-							if (dx == 0 && dy == 0 && dz == 0)
-								continue;
-
-							int nx = x + dx, ny = y + dy, nz = z + dz;
-							if (nx >= 0 && nx < Width && ny >= 0 && ny < Height && nz >= 0 && nz < Depth)
-							{
-								auto &neighbor = m_data[CoordsToIndex(nz, nx, ny)];
-								if (neighbor.m_type == Cube::Type::None)
-								{
-									hasVisibleNeighbor = true;
-								}
-							}
-						}
-					}
-				}
-				cube.m_isVisible = hasVisibleNeighbor;
-			}
-		}
-	}
-}
-
-template <uint8_t Depth, uint8_t Width, uint8_t Height>
-inline Ray::HitType Chunk<Depth, Width, Height>::Hit(const Ray &ray, Ray::time_t min, Ray::time_t max, HitRecord &record) const
-{
-	AABB::HitRecord chunkRecord;
-	if (m_aabb.Hit(ray, min, max, chunkRecord) == Ray::HitType::Miss)
-	{
-		return Ray::HitType::Miss;
-	}
-
-	float closestDistance = std::numeric_limits<float>::max();
-	Ray::HitType hitType = Ray::HitType::Miss;
-
-	glm::vec3 chunkOrigin = glm::vec3(m_origin.x, 0.0f, m_origin.y); // Przesunięcie chunku w świecie
-
-	for (uint8_t x = 0; x < Width; ++x)
-	{
-		for (uint8_t y = 0; y < Height; ++y)
-		{
-			for (uint8_t z = 0; z < Depth; ++z)
-			{
-				auto &cube = m_data[CoordsToIndex(z, x, y)];
-
-				if (cube.m_type == Cube::Type::None)
-					continue;
-
-				// Uwzględniamy pozycję chunku w świecie
-				glm::vec3 cubeMin = chunkOrigin + glm::vec3(x, y, z);
-				glm::vec3 cubeMax = cubeMin + glm::vec3(1.0f);
-				AABB cubeAABB(cubeMin, cubeMax);
-
-				// Test ray against the cube
-				AABB::HitRecord cubeRecord;
-				if (cubeAABB.Hit(ray, min, max, cubeRecord) == Ray::HitType::Hit)
-				{
-					float distance = glm::distance(ray.Origin(), cubeRecord.m_point);
-					if (distance < closestDistance)
-					{
-						closestDistance = distance;
-						record.m_cubeIndex = glm::ivec3(glm::floor(cubeRecord.m_point) - chunkOrigin);
-						hitType = Ray::HitType::Hit;
-					}
-				}
-			}
-		}
-	}
-
-	if (hitType == Ray::HitType::Hit)
-	{
-		std::cout << "Hit! Block at: " << record.m_cubeIndex.x << ", " << record.m_cubeIndex.y << ", " << record.m_cubeIndex.z << std::endl;
-	}
-
-	return hitType;
-}
-
-template <uint8_t Depth, uint8_t Width, uint8_t Height>
-inline bool Chunk<Depth, Width, Height>::RemoveBlock(uint8_t x, uint8_t y, uint8_t z)
-{
-	if (x >= Width || y >= Height || z >= Depth)
-		return false; // Out of bounds
-
-	CubeData &cube = m_data[z * Width * Height + y * Width + x];
-	if (cube.m_type == Cube::Type::None)
-		return false; // No block to remove
-
-	cube.m_type = Cube::Type::None;
-	cube.m_isVisible = false;
-	UpdateVisibility(); // Zaktualizuj widoczność bloków
-
-	return true;
-}
-
-template <uint8_t Depth, uint8_t Width, uint8_t Height>
-inline bool Chunk<Depth, Width, Height>::PlaceBlock(uint8_t x, uint8_t y, uint8_t z, Cube::Type type)
-{
-	if (x >= Width || y >= Height || z >= Depth)
-		return false; // Out of bounds
-
-	CubeData &cube = m_data[z * Width * Height + y * Width + x];
-	if (cube.m_type != Cube::Type::None)
-		return false; // Block already exists
-
-	cube.m_type = type;
-	cube.m_isVisible = true;
-	UpdateVisibility(); // Zaktualizuj widoczność bloków
-
-	return true;
-}
+#pragma once
+#include "Cube.hpp"
+#include "TerrainGenerator.hpp"
+#include "AABB.hpp"
+#include "Ray.hpp"
+#include "VoxelRay.hpp"
+#include "ChunkMesh.hpp"
+#include "CubeInstances.hpp"
+#include "BlockStorage.hpp"
+#include "Occupancy.hpp"
+#include "Random.hpp"
+#include "Profiler.hpp"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <memory>
+#include <span>
+#include <vector>
+#include <iostream>
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+class Chunk
+{
+public:
+	// Blocks are stored y-major, then x, then z (see CoordsToIndex); loops over
+	// the whole chunk go in that order so they walk memory linearly
+	using FlattenData_t = std::array<Cube::Type, Depth * Width * Height>;
+	static constexpr size_t s_blockCount = Depth * Width * Height;
+	// Sections are horizontal slabs, s_sectionHeight blocks thick
+	static constexpr uint8_t s_sectionHeight = Height % 4 == 0 ? 4 : 1;
+	using Storage_t = BlockStorage<Depth * Width * s_sectionHeight, Height / s_sectionHeight>;
+	using Occupancy_t = Occupancy<Depth, Width, Height>;
+
+private:
+	using BlockBits_t = std::bitset<Depth * Width * Height>;
+	// One bit per block for each Cube::Face, set when that face is exposed
+	using VisibilityData_t = std::array<BlockBits_t, 6>;
+
+	static_assert(sizeof(FlattenData_t) == Depth * Width * Height, "one byte per block");
+
+public:
+	Chunk(const glm::vec2 &origin);
+	// Safe on a worker thread while the chunk has no neighbours
+	void Generate(const TerrainGenerator &generator, int worldX, int worldZ);
+	// Replaces every block, e.g. with a chunk loaded from disk; same rules as Generate
+	void Assign(std::span<const Cube::Type, s_blockCount> data);
+	void Flatten(std::span<Cube::Type, s_blockCount> data) const;
+	// Edited since it was generated, loaded or last saved
+	bool IsModified() const { return m_modified; }
+	void MarkSaved() { m_modified = false; }
+	// Mesh of the exposed faces, patched with the slices Update rebuilt;
+	// valid until the next Update
+	const ChunkMesh &AssembleMesh();
+	// Changed since the last AssembleMesh
+	bool MeshChanged() const { return m_meshDirty; }
+	// Same faces as whole visible blocks, one instance list per type; Update
+	// keeps them current from the first call on
+	CubeInstances &Instances();
+	// Recomputes visibility and mesh slices of whatever changed since the last call
+	void Update();
+	bool NeedsUpdate() const { return m_visibilityDirty || !m_dirtyCells.empty(); }
+	ChunkMesh BuildMesh() const;
+
+	// Level l of detail merges 2^l blocks along each axis; 0 is BuildMesh
+	static constexpr int s_lodLevels = 3;
+	// Mesh for drawing far away at level 1 .. s_lodLevels - 1. A cell is solid
+	// when any of its blocks is and takes the most common type of its highest
+	// solid layer. Faces on the chunk's sides are kept whatever the neighbour
+	// holds: they are skirts over the steps to chunks drawn at another level.
+	// Any other level gives an empty mesh.
+	ChunkMesh BuildLodMesh(int level) const;
+	// Changes with every edit of the blocks, for caches of what is built from
+	// them. Unique across chunks, so a chunk loaded again never matches what
+	// was built from its predecessor at the same place.
+	uint32_t Revision() const { return m_revision; }
+
+	struct HitRecord
+	{
+		glm::ivec3 m_cubeIndex;
+		glm::ivec3 m_neighbourIndex; // Next to the hit face, may lie in a neighbouring chunk
+		Cube::Face m_face;			 // Face of the hit cube the ray came in through
+		Ray::time_t m_time;
+	};
+
+	// First solid block along the ray, walked cell by cell (VoxelRay) through
+	// non-empty bricks; an empty brick is crossed in a single step
+	Ray::HitType Hit(const Ray &ray, Ray::time_t min, Ray::time_t max, HitRecord &record) const;
+	// None outside the chunk
+	Cube::Type BlockAt(int x, int y, int z) const;
+	bool RemoveBlock(uint8_t x, uint8_t y, uint8_t z);
+	bool PlaceBlock(uint8_t x, uint8_t y, uint8_t z, Cube::Type type);
+	glm::vec2 getOrigin() { return m_origin; };
+	const AABB &Bounds() const { return m_aabb; }
+	// Boxes wholly inside solid blocks (columns of bricks solid from the
+	// bottom up), in world space, for the occlusion buffer
+	const std::vector<AABB> &Occluders() const { return m_occluders; }
+	// Bounds cut down to the highest solid block; empty when there are none
+	const AABB &SolidBounds() const { return m_solidBounds; }
+	void SetNeighbour(Cube::Face face, Chunk *neighbour);
+	const Storage_t &Blocks() const { return m_blocks; }
+	// Solid blocks only, for empty space skipping in queries
+	const Occupancy_t &Occupied() const { return m_occupancy; }
+	// Content hash of the blocks; a regenerated chunk must hash the same
+	uint64_t Hash() const;
+
+private:
+	static size_t CoordsToIndex(size_t depth, size_t width, size_t height);
+	bool IsAir(int x, int y, int z) const;
+	auto FaceLookUp() const;
+	void UpdateVisibility();
+	void UpdateVisibility(int x, int y, int z);
+	void MarkDirty(int x, int y, int z);
+	void MarkCellDirty(int x, int y, int z);
+	// Only one face of the cell can have changed, e.g. next to an edit
+	void MarkFaceDirty(int x, int y, int z, Cube::Face face);
+	void MarkBorderDirty(Cube::Face face);
+	template <typename Callback>
+	static void ForEachBorderCell(Cube::Face face, const Callback &callback);
+	static const BlockBits_t &BorderMask(Cube::Face face);
+	template <typename Lookup>
+	void RebuildSlice(Cube::Face face, int slice, const Lookup &faceAt);
+	void UpdateInstances();
+	void UpdateInstance(int x, int y, int z);
+	void UpdateOccluders();
+	template <int Scale>
+	ChunkMesh BuildScaledMesh() const;
+	bool IsVisible(size_t index) const;
+
+	Storage_t m_blocks;
+	Occupancy_t m_occupancy;
+	VisibilityData_t m_visibility;
+	glm::vec2 m_origin;
+	AABB m_aabb;
+	std::vector<AABB> m_occluders;
+	AABB m_solidBounds{glm::vec3(0.0f), glm::vec3(0.0f)};
+	std::array<Chunk *, 6> m_neighbours{}; // Indexed by Cube::Face
+	ChunkMesher<Depth, Width, Height> m_mesher;
+	std::unique_ptr<CubeInstances> m_instances; // Only once asked for
+	std::vector<glm::ivec3> m_dirtyCells;
+	std::array<std::bitset<256>, 6> m_dirtySlices; // Indexed by Cube::Face
+	bool m_visibilityDirty{true};
+	bool m_meshDirty{true};
+	bool m_modified{false};
+	uint32_t m_revision{0};
+	inline static std::atomic<uint32_t> s_revisions{0}; // Generate runs on workers
+};
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline Chunk<Depth, Width, Height>::Chunk(const glm::vec2 &origin) : m_origin(origin),
+																	  m_aabb(glm::vec3(origin.x, 0, origin.y), glm::vec3(origin.x + Width, Height, origin.y + Depth))
+{
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline void Chunk<Depth, Width, Height>::Generate(const TerrainGenerator &generator, int worldX, int worldZ)
+{
+	PROFILE_ZONE("Chunk::Generate");
+	FlattenData_t data;
+	generator.Generate(glm::ivec3(Width, Height, Depth), worldX, worldZ, data);
+	Assign(data);
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline void Chunk<Depth, Width, Height>::Assign(std::span<const Cube::Type, s_blockCount> data)
+{
+	m_blocks.Assign(data);
+	m_occupancy.Assign(data);
+	m_modified = false;
+	m_revision = ++s_revisions;
+
+	// Widoczność liczona leniwie, gdy sąsiednie chunki też są już wygenerowane
+	m_visibilityDirty = true;
+	m_meshDirty = true;
+	for (uint8_t f = 0; f < 6; ++f)
+	{
+		if (Chunk *neighbour = m_neighbours[f])
+			neighbour->MarkBorderDirty(OppositeFace(static_cast<Cube::Face>(f)));
+	}
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline void Chunk<Depth, Width, Height>::Flatten(std::span<Cube::Type, s_blockCount> data) const
+{
+	for (size_t i = 0; i < data.size(); ++i)
+		data[i] = m_blocks.Get(i);
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline uint64_t Chunk<Depth, Width, Height>::Hash() const
+{
+	// Osiem bloków na słowo, indeks słowa w mieszaniu, żeby liczyła się pozycja
+	uint64_t hash = 0;
+	uint64_t word = 0;
+	for (size_t i = 0; i < Storage_t::s_size; ++i)
+	{
+		word = (word << 8) | static_cast<uint8_t>(m_blocks.Get(i));
+		if (i % 8 == 7 || i + 1 == Storage_t::s_size)
+		{
+			hash = Random::At(hash ^ word, i / 8);
+			word = 0;
+		}
+	}
+	return hash;
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline const ChunkMesh &Chunk<Depth, Width, Height>::AssembleMesh()
+{
+	PROFILE_ZONE("Chunk::AssembleMesh");
+	m_meshDirty = false;
+	return m_mesher.Assemble();
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline CubeInstances &Chunk<Depth, Width, Height>::Instances()
+{
+	if (!m_instances)
+	{
+		m_instances = std::make_unique<CubeInstances>(Depth * Width * Height);
+		UpdateInstances();
+	}
+	return *m_instances;
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline void Chunk<Depth, Width, Height>::Update()
+{
+	if (!NeedsUpdate())
+		return;
+
+	PROFILE_ZONE("Chunk::Update");
+	if (m_visibilityDirty)
+	{
+		UpdateVisibility();
+		if (m_instances)
+			UpdateInstances();
+		const auto faceAt = FaceLookUp();
+		for (uint8_t f = 0; f < 6; ++f)
+		{
+			const Cube::Face face = static_cast<Cube::Face>(f);
+			for (int slice = 0; slice < m_mesher.SliceCount(face); ++slice)
+				RebuildSlice(face, slice, faceAt);
+		}
+		m_visibilityDirty = false;
+		m_meshDirty = true;
+		m_dirtyCells.clear();
+		for (auto &slices : m_dirtySlices)
+			slices.reset();
+		UpdateOccluders();
+		return;
+	}
+
+	if (m_dirtyCells.empty())
+		return;
+
+	for (const glm::ivec3 &cell : m_dirtyCells)
+	{
+		UpdateVisibility(cell.x, cell.y, cell.z);
+		if (m_instances)
+			UpdateInstance(cell.x, cell.y, cell.z);
+	}
+	m_dirtyCells.clear();
+
+	const auto faceAt = FaceLookUp();
+	for (uint8_t f = 0; f < 6; ++f)
+	{
+		const Cube::Face face = static_cast<Cube::Face>(f);
+		for (int slice = 0; slice < m_mesher.SliceCount(face); ++slice)
+		{
+			if (m_dirtySlices[f].test(slice))
+				RebuildSlice(face, slice, faceAt);
+		}
+		m_dirtySlices[f].reset();
+	}
+	UpdateOccluders();
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline void Chunk<Depth, Width, Height>::UpdateOccluders()
+{
+	const glm::vec3 origin(m_origin.x, 0.0f, m_origin.y);
+	m_solidBounds = AABB(origin, origin + glm::vec3(Width, m_occupancy.Top(), Depth));
+
+	// Prostokąty kolumn cegieł tej samej wysokości, zachłannie: najpierw wzdłuż z, potem x
+	m_occluders.clear();
+	const glm::ivec3 bricks = Occupancy_t::Bricks();
+	std::array<int, ((Width + 3) / 4) * ((Depth + 3) / 4)> heights;
+	for (int bx = 0; bx < bricks.x; ++bx)
+		for (int bz = 0; bz < bricks.z; ++bz)
+			heights[bx * bricks.z + bz] = m_occupancy.SolidHeight(bx, bz);
+
+	for (int bx = 0; bx < bricks.x; ++bx)
+	{
+		for (int bz = 0; bz < bricks.z; ++bz)
+		{
+			const int height = heights[bx * bricks.z + bz];
+			if (height == 0)
+				continue;
+			int endZ = bz + 1;
+			while (endZ < bricks.z && heights[bx * bricks.z + endZ] == height)
+				++endZ;
+			int endX = bx + 1;
+			const auto row = [&heights, &bricks](int x)
+			{ return heights.begin() + x * bricks.z; };
+			while (endX < bricks.x && std::all_of(row(endX) + bz, row(endX) + endZ, [height](int h)
+												  { return h == height; }))
+				++endX;
+			for (int x = bx; x < endX; ++x)
+				std::fill(row(x) + bz, row(x) + endZ, 0);
+			m_occluders.emplace_back(origin + glm::vec3(bx * 4, 0, bz * 4),
+									 origin + glm::vec3(std::min(endX * 4, int(Width)), height, std::min(endZ * 4, int(Depth))));
+		}
+	}
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+template <typename Lookup>
+inline void Chunk<Depth, Width, Height>::RebuildSlice(Cube::Face face, int slice, const Lookup &faceAt)
+{
+	// Warstwa bez pełnych bloków nie ma żadnej ściany
+	if (m_occupancy.IsLayerEmpty(GetFaceAxes(face).m_normal, slice))
+		m_mesher.ClearSlice(face, slice);
+	else
+		m_mesher.RebuildSlice(face, slice, faceAt);
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline auto Chunk<Depth, Width, Height>::FaceLookUp() const
+{
+	return [this](int x, int y, int z, Cube::Face face)
+	{
+		const size_t index = CoordsToIndex(z, x, y);
+		return m_visibility[static_cast<uint8_t>(face)][index] ? m_blocks.Get(index) : Cube::Type::None;
+	};
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline ChunkMesh Chunk<Depth, Width, Height>::BuildMesh() const
+{
+	PROFILE_ZONE("Chunk::BuildMesh");
+	return GreedyMesh<Depth, Width, Height>(FaceLookUp());
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline ChunkMesh Chunk<Depth, Width, Height>::BuildLodMesh(int level) const
+{
+	PROFILE_ZONE("Chunk::BuildLodMesh");
+	switch (level)
+	{
+	case 1:
+		return BuildScaledMesh<2>();
+	case 2:
+		return BuildScaledMesh<4>();
+	default:
+		return ChunkMesh();
+	}
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+template <int Scale>
+inline ChunkMesh Chunk<Depth, Width, Height>::BuildScaledMesh() const
+{
+	static_assert(Depth % Scale == 0 && Width % Scale == 0 && Height % Scale == 0, "whole cells only");
+	constexpr int depth = Depth / Scale, width = Width / Scale, height = Height / Scale;
+	const auto cellIndex = [](int x, int y, int z)
+	{ return (y * width + x) * depth + z; };
+
+	std::array<Cube::Type, depth * width * height> cells;
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			for (int z = 0; z < depth; ++z)
+			{
+				const glm::ivec3 min(x * Scale, y * Scale, z * Scale);
+				Cube::Type &cell = cells[cellIndex(x, y, z)];
+				cell = Cube::Type::None;
+				if (m_occupancy.IsEmpty(min, min + glm::ivec3(Scale - 1)))
+					continue;
+
+				// Najwyższa niepusta warstwa komórki decyduje o typie (trawa na wierzchu)
+				for (int layer = Scale - 1; layer >= 0 && cell == Cube::Type::None; --layer)
+				{
+					std::array<int, Cube::s_typeCount> counts{};
+					for (int dx = 0; dx < Scale; ++dx)
+					{
+						for (int dz = 0; dz < Scale; ++dz)
+							++counts[static_cast<size_t>(m_blocks.Get(CoordsToIndex(min.z + dz, min.x + dx, min.y + layer)))];
+					}
+					counts[static_cast<size_t>(Cube::Type::None)] = 0;
+					const auto most = std::max_element(counts.begin(), counts.end());
+					if (*most > 0)
+						cell = static_cast<Cube::Type>(most - counts.begin());
+				}
+			}
+		}
+	}
+
+	std::array<glm::ivec3, 6> normals;
+	for (uint8_t f = 0; f < 6; ++f)
+		normals[f] = FaceNormal(static_cast<Cube::Face>(f));
+	const auto faceAt = [&cells, &cellIndex, &normals](int x, int y, int z, Cube::Face face)
+	{
+		const Cube::Type type = cells[cellIndex(x, y, z)];
+		const glm::ivec3 next = glm::ivec3(x, y, z) + normals[static_cast<uint8_t>(face)];
+		if (type == Cube::Type::None || next.y < 0)
+			return Cube::Type::None;
+		// Poza chunkiem zawsze powietrze: ściany boczne to fartuchy
+		if (next.y >= height || next.x < 0 || next.x >= width || next.z < 0 || next.z >= depth)
+			return type;
+		return cells[cellIndex(next.x, next.y, next.z)] == Cube::Type::None ? type : Cube::Type::None;
+	};
+
+	ChunkMesh mesh = GreedyMesh<depth, width, height>(faceAt);
+	for (MeshVertex &vertex : mesh.m_vertices)
+	{
+		vertex.m_x *= Scale;
+		vertex.m_y *= Scale;
+		vertex.m_z *= Scale;
+		vertex.m_u *= Scale; // Tekstura nadal raz na blok
+		vertex.m_v *= Scale;
+	}
+	return mesh;
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline size_t Chunk<Depth, Width, Height>::CoordsToIndex(size_t depth, size_t width, size_t height)
+{
+	return height * static_cast<size_t>(Depth) * static_cast<size_t>(Width) + width * static_cast<size_t>(Depth) + depth;
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline void Chunk<Depth, Width, Height>::SetNeighbour(Cube::Face face, Chunk *neighbour)
+{
+	m_neighbours[static_cast<uint8_t>(face)] = neighbour;
+	MarkBorderDirty(face);
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline bool Chunk<Depth, Width, Height>::IsAir(int x, int y, int z) const
+{
+	// Below the world nothing is ever seen, above it is open sky
+	if (y < 0)
+		return false;
+	if (y >= Height)
+		return true;
+
+	const Chunk *chunk = this;
+	if (x < 0)
+	{
+		chunk = m_neighbours[static_cast<uint8_t>(Cube::Face::Left)];
+		x += Width;
+	}
+	else if (x >= Width)
+	{
+		chunk = m_neighbours[static_cast<uint8_t>(Cube::Face::Right)];
+		x -= Width;
+	}
+	else if (z < 0)
+	{
+		chunk = m_neighbours[static_cast<uint8_t>(Cube::Face::Back)];
+		z += Depth;
+	}
+	else if (z >= Depth)
+	{
+		chunk = m_neighbours[static_cast<uint8_t>(Cube::Face::Front)];
+		z -= Depth;
+	}
+
+	// Brak sąsiada oznacza krawędź świata, więc ściana jest odsłonięta
+	if (!chunk)
+		return true;
+
+	return chunk->m_blocks.Get(CoordsToIndex(z, x, y)) == Cube::Type::None;
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline void Chunk<Depth, Width, Height>::UpdateVisibility()
+{
+	// Cała warstwa bitów naraz: ściana jest widoczna, gdy blok jest pełny, a jego
+	// sąsiad nie. Wewnątrz chunku sąsiad to ten sam zbiór przesunięty o krok
+	// indeksu wzdłuż normalnej; komórki brzegowe patrzą do sąsiedniego chunku.
+	BlockBits_t solid;
+	for (size_t section = 0; section < Storage_t::s_sectionCount; ++section)
+	{
+		const size_t first = section * Storage_t::s_sectionSize;
+		const size_t last = first + Storage_t::s_sectionSize;
+		if (m_blocks.IsUniform(section))
+		{
+			// Jednolita sekcja: powietrze zostaje zerami, pełna ustawia cały zakres
+			if (m_blocks.Get(first) != Cube::Type::None)
+			{
+				for (size_t i = first; i < last; ++i)
+					solid[i] = true;
+			}
+			continue;
+		}
+
+		for (size_t i = first; i < last; ++i)
+			solid[i] = m_blocks.Get(i) != Cube::Type::None;
+	}
+
+	const glm::ivec3 strides{Depth, Depth * Width, 1}; // Krok indeksu dla x, y, z
+	for (uint8_t f = 0; f < 6; ++f)
+	{
+		const Cube::Face face = static_cast<Cube::Face>(f);
+		const FaceAxes axes = GetFaceAxes(face);
+		const size_t stride = strides[axes.m_normal];
+
+		BlockBits_t covered = axes.m_positive ? solid >> stride : solid << stride;
+		covered &= ~BorderMask(face);
+		ForEachBorderCell(face, [&](int x, int y, int z)
+						  {
+			const size_t index = CoordsToIndex(z, x, y);
+			if (!solid[index])
+				return;
+			const glm::ivec3 n = glm::ivec3(x, y, z) + FaceNormal(face);
+			covered[index] = !IsAir(n.x, n.y, n.z); });
+
+		m_visibility[f] = solid & ~covered;
+	}
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline void Chunk<Depth, Width, Height>::UpdateVisibility(int x, int y, int z)
+{
+	const size_t index = CoordsToIndex(z, x, y);
+	const bool solid = m_blocks.Get(index) != Cube::Type::None;
+
+	// Tylko 6 sąsiadów przez ściany, także z sąsiednich chunków
+	for (uint8_t f = 0; f < 6; ++f)
+	{
+		const glm::ivec3 n = glm::ivec3(x, y, z) + FaceNormal(static_cast<Cube::Face>(f));
+		m_visibility[f][index] = solid && IsAir(n.x, n.y, n.z);
+	}
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline void Chunk<Depth, Width, Height>::UpdateInstances()
+{
+	for (size_t y = 0; y < Height; ++y)
+	{
+		for (size_t x = 0; x < Width; ++x)
+		{
+			for (size_t z = 0; z < Depth; ++z)
+			{
+				UpdateInstance(x, y, z);
+			}
+		}
+	}
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline void Chunk<Depth, Width, Height>::UpdateInstance(int x, int y, int z)
+{
+	const size_t index = CoordsToIndex(z, x, y);
+	m_instances->Set(index, glm::ivec3(x, y, z), IsVisible(index) ? m_blocks.Get(index) : Cube::Type::None);
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline bool Chunk<Depth, Width, Height>::IsVisible(size_t index) const
+{
+	for (const auto &faces : m_visibility)
+	{
+		if (faces[index])
+			return true;
+	}
+	return false;
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline void Chunk<Depth, Width, Height>::MarkDirty(int x, int y, int z)
+{
+	// Zmiana bloku wpływa tylko na niego i na jedną ścianę każdego z 6 sąsiadów
+	MarkCellDirty(x, y, z);
+	for (uint8_t f = 0; f < 6; ++f)
+	{
+		const Cube::Face face = static_cast<Cube::Face>(f);
+		const glm::ivec3 n = glm::ivec3(x, y, z) + FaceNormal(face);
+		if (n.y < 0 || n.y >= Height)
+			continue;
+
+		if (n.x >= 0 && n.x < Width && n.z >= 0 && n.z < Depth)
+			MarkFaceDirty(n.x, n.y, n.z, OppositeFace(face));
+		else if (Chunk *neighbour = m_neighbours[f])
+			neighbour->MarkFaceDirty((n.x + Width) % Width, n.y, (n.z + Depth) % Depth, OppositeFace(face));
+	}
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline void Chunk<Depth, Width, Height>::MarkCellDirty(int x, int y, int z)
+{
+	m_meshDirty = true;
+	if (m_visibilityDirty)
+		return; // Full rebuild already pending
+
+	m_dirtyCells.push_back(glm::ivec3(x, y, z));
+	m_dirtySlices[static_cast<uint8_t>(Cube::Face::Left)].set(x);
+	m_dirtySlices[static_cast<uint8_t>(Cube::Face::Right)].set(x);
+	m_dirtySlices[static_cast<uint8_t>(Cube::Face::Bottom)].set(y);
+	m_dirtySlices[static_cast<uint8_t>(Cube::Face::Top)].set(y);
+	m_dirtySlices[static_cast<uint8_t>(Cube::Face::Back)].set(z);
+	m_dirtySlices[static_cast<uint8_t>(Cube::Face::Front)].set(z);
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline void Chunk<Depth, Width, Height>::MarkFaceDirty(int x, int y, int z, Cube::Face face)
+{
+	m_meshDirty = true;
+	if (m_visibilityDirty)
+		return;
+
+	m_dirtyCells.push_back(glm::ivec3(x, y, z));
+	m_dirtySlices[static_cast<uint8_t>(face)].set(glm::ivec3(x, y, z)[GetFaceAxes(face).m_normal]);
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline void Chunk<Depth, Width, Height>::MarkBorderDirty(Cube::Face face)
+{
+	ForEachBorderCell(face, [this](int x, int y, int z)
+					  { MarkCellDirty(x, y, z); });
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+template <typename Callback>
+inline void Chunk<Depth, Width, Height>::ForEachBorderCell(Cube::Face face, const Callback &callback)
+{
+	const glm::ivec3 size{Width, Height, Depth};
+	const FaceAxes axes = GetFaceAxes(face);
+
+	glm::ivec3 pos{0};
+	pos[axes.m_normal] = axes.m_positive ? size[axes.m_normal] - 1 : 0;
+	for (int v = 0; v < size[axes.m_v]; ++v)
+	{
+		pos[axes.m_v] = v;
+		for (int u = 0; u < size[axes.m_u]; ++u)
+		{
+			pos[axes.m_u] = u;
+			callback(pos.x, pos.y, pos.z);
+		}
+	}
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline const typename Chunk<Depth, Width, Height>::BlockBits_t &Chunk<Depth, Width, Height>::BorderMask(Cube::Face face)
+{
+	// Blocks on the given side of the chunk, built once per chunk size
+	static const std::array<BlockBits_t, 6> s_masks = []
+	{
+		std::array<BlockBits_t, 6> masks;
+		for (uint8_t f = 0; f < 6; ++f)
+		{
+			ForEachBorderCell(static_cast<Cube::Face>(f), [&masks, f](int x, int y, int z)
+							  { masks[f][CoordsToIndex(z, x, y)] = true; });
+		}
+		return masks;
+	}();
+	return s_masks[static_cast<uint8_t>(face)];
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline Ray::HitType Chunk<Depth, Width, Height>::Hit(const Ray &ray, Ray::time_t min, Ray::time_t max, HitRecord &record) const
+{
+	// Tylko odcinek promienia wewnątrz chunku, w lokalnych współrzędnych
+	if (!m_aabb.Clip(ray, min, max))
+		return Ray::HitType::Miss;
+
+	const Ray local(ray.Origin() - glm::vec3(m_origin.x, 0.0f, m_origin.y), ray.Direction());
+	typename Occupancy_t::TraceHit hit;
+	if (!m_occupancy.Trace(local, min, max, hit))
+		return Ray::HitType::Miss;
+
+	record.m_cubeIndex = hit.m_cell;
+	record.m_face = hit.m_face;
+	record.m_neighbourIndex = hit.m_cell + FaceNormal(hit.m_face);
+	record.m_time = hit.m_time;
+	return Ray::HitType::Hit;
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline Cube::Type Chunk<Depth, Width, Height>::BlockAt(int x, int y, int z) const
+{
+	if (x < 0 || y < 0 || z < 0 || x >= Width || y >= Height || z >= Depth)
+		return Cube::Type::None;
+	return m_blocks.Get(CoordsToIndex(z, x, y));
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline bool Chunk<Depth, Width, Height>::RemoveBlock(uint8_t x, uint8_t y, uint8_t z)
+{
+	if (x >= Width || y >= Height || z >= Depth)
+		return false; // Out of bounds
+
+	const size_t index = CoordsToIndex(z, x, y);
+	if (m_blocks.Get(index) == Cube::Type::None)
+		return false; // No block to remove
+
+	m_blocks.Set(index, Cube::Type::None);
+	m_occupancy.Set(x, y, z, false);
+	m_modified = true;
+	m_revision = ++s_revisions;
+	MarkDirty(x, y, z); // Widoczność i siatka przeliczane leniwie w Update
+
+	return true;
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline bool Chunk<Depth, Width, Height>::PlaceBlock(uint8_t x, uint8_t y, uint8_t z, Cube::Type type)
+{
+	if (x >= Width || y >= Height || z >= Depth)
+		return false; // Out of bounds
+
+	const size_t index = CoordsToIndex(z, x, y);
+	if (m_blocks.Get(index) != Cube::Type::None)
+		return false; // Block already exists
+
+	m_blocks.Set(index, type);
+	m_occupancy.Set(x, y, z, type != Cube::Type::None);
+	m_modified = true;
+	m_revision = ++s_revisions;
+	MarkDirty(x, y, z); // Widoczność i siatka przeliczane leniwie w Update
+
+	return true;
+}
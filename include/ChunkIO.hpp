@@ -0,0 +1,74 @@
+#pragma once
+#include "Cube.hpp"
+#include "RegionFile.hpp"
+#include "SpscQueue.hpp"
+
+#include <glm/glm.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Region file reads and writes on a thread of their own. The main thread
+// queues requests and polls results; both directions are lock-free SPSC
+// queues, so the main thread never waits for the disk. Loads are answered
+// first, from not yet written saves when there is one. Saves are batched:
+// they go out only while no load is queued, one region rewrite at a time
+// with every chunk queued for that region. A region that cannot be written
+// keeps its chunks queued and is tried again a little later.
+class ChunkIO
+{
+public:
+	using Blocks_t = std::vector<Cube::Type>;
+
+	struct Result
+	{
+		glm::ivec2 m_coords{0};
+		bool m_found{false}; // false: never saved, generate it
+		Blocks_t m_blocks;
+	};
+
+	ChunkIO(std::filesystem::path directory, const glm::ivec3 &chunkSize);
+	ChunkIO(const ChunkIO &) = delete;
+	ChunkIO &operator=(const ChunkIO &) = delete;
+	// Finishes every queued write first, giving each failed region one more
+	// try; chunks that still cannot be written are reported on std::cerr
+	~ChunkIO();
+
+	// Main thread only
+	void Load(const glm::ivec2 &coords);
+	void Save(const glm::ivec2 &coords, Blocks_t blocks);
+	bool Poll(Result &result);
+
+private:
+	struct Request
+	{
+		glm::ivec2 m_coords{0};
+		bool m_save{false};
+		Blocks_t m_blocks;
+	};
+
+	RegionStore m_store; // Only touched by m_thread
+	glm::ivec3 m_chunkSize;
+	SpscQueue<Request, 1024> m_requests;
+	SpscQueue<Result, 1024> m_results;
+	std::deque<Request> m_overflow; // Requests that did not fit yet, main thread side
+	std::unordered_map<uint64_t, Request> m_unsaved; // IO thread side
+	// Regions whose last write failed and when to try them again, IO thread side
+	using Clock = std::chrono::steady_clock;
+	std::unordered_map<uint64_t, Clock::time_point> m_failed;
+	static constexpr std::chrono::milliseconds s_retryDelay{1000};
+	std::atomic<uint32_t> m_signal{0};
+	std::atomic<bool> m_stop{false};
+	std::thread m_thread;
+
+	void Push(Request request);
+	void FlushOverflow();
+	void Run();
+	bool Serve(bool stopping);
+	static uint64_t Key(const glm::ivec2 &coords);
+};
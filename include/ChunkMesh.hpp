@@ -0,0 +1,324 @@
+#pragma once
+#include "Cube.hpp"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <vector>
+
+// Packed vertex of a chunk mesh. The position is a chunk-local block corner,
+// (m_u, m_v) is the offset inside the merged quad in blocks, so the shader can
+// repeat the face texture once per block. The shader maps m_type to a layer of
+// the palette's texture array, so a whole chunk is one draw call.
+struct MeshVertex
+{
+	uint8_t m_x;
+	uint8_t m_y;
+	uint8_t m_z;
+	uint8_t m_face;
+	uint8_t m_u;
+	uint8_t m_v;
+	uint8_t m_type;
+	uint8_t m_padding;
+};
+
+struct ChunkMesh
+{
+	std::vector<MeshVertex> m_vertices;
+	std::vector<uint32_t> m_indices;
+};
+
+// Axis along the face normal and the two in-plane axes (0 = x, 1 = y, 2 = z).
+// The in-plane axes are ordered so that u x v points along +normal.
+struct FaceAxes
+{
+	uint8_t m_normal;
+	uint8_t m_u;
+	uint8_t m_v;
+	bool m_positive;
+};
+
+constexpr FaceAxes GetFaceAxes(Cube::Face face)
+{
+	switch (face)
+	{
+	case Cube::Face::Front:
+		return {2, 0, 1, true};
+	case Cube::Face::Back:
+		return {2, 0, 1, false};
+	case Cube::Face::Left:
+		return {0, 1, 2, false};
+	case Cube::Face::Right:
+		return {0, 1, 2, true};
+	case Cube::Face::Bottom:
+		return {1, 2, 0, false};
+	default:
+		return {1, 2, 0, true};
+	}
+}
+
+inline glm::ivec3 FaceNormal(Cube::Face face)
+{
+	const FaceAxes axes = GetFaceAxes(face);
+	glm::ivec3 normal{0};
+	normal[axes.m_normal] = axes.m_positive ? 1 : -1;
+	return normal;
+}
+
+constexpr Cube::Face OppositeFace(Cube::Face face)
+{
+	return static_cast<Cube::Face>(static_cast<uint8_t>(face) ^ 1);
+}
+
+// Greedy mesher of a Depth x Width x Height block grid. Coplanar faces of the
+// same type are merged into rectangles, one slice of the grid at a time. The
+// quads of every slice are kept and so is the assembled mesh, with the range
+// each slice takes in it, so after an edit only the touched slices are merged
+// again and only their quads are written into the mesh.
+// faceAt(x, y, z, face) returns the type of the block at (x, y, z) if that
+// face of it is exposed, None otherwise.
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+class ChunkMesher
+{
+public:
+	template <typename FaceLookUp>
+	void RebuildSlice(Cube::Face face, int slice, const FaceLookUp &faceAt);
+	template <typename FaceLookUp>
+	void RebuildAll(const FaceLookUp &faceAt);
+	// For a slice known to have no exposed faces
+	void ClearSlice(Cube::Face face, int slice);
+
+	// Brings the mesh up to date with the slices rebuilt since the last call.
+	// Slices keep their quad count after most edits; then only their vertices
+	// are rewritten. Otherwise the vertices are laid out again, the untouched
+	// slices copied as they are. The index buffer only depends on the number
+	// of quads.
+	const ChunkMesh &Assemble();
+
+	static constexpr int SliceCount(Cube::Face face)
+	{
+		const uint8_t axis = GetFaceAxes(face).m_normal;
+		return axis == 0 ? Width : axis == 1 ? Height : Depth;
+	}
+
+private:
+	struct Quad
+	{
+		Cube::Type m_type;
+		Cube::Face m_face;
+		glm::ivec3 m_origin;
+		int m_width;
+		int m_height;
+	};
+
+	// Slices of all faces in one row, face by face
+	static constexpr int s_sliceCount = 2 * (Width + Height + Depth);
+	static constexpr int SliceIndex(Cube::Face face, int slice)
+	{
+		int index = slice;
+		for (uint8_t f = 0; f < static_cast<uint8_t>(face); ++f)
+			index += SliceCount(static_cast<Cube::Face>(f));
+		return index;
+	}
+
+	std::array<std::vector<Quad>, s_sliceCount> m_slices;
+	std::vector<Cube::Type> m_mask;
+	ChunkMesh m_mesh;
+	std::vector<MeshVertex> m_spare; // The previous layout, reused for the next one
+	// First quad of each slice in m_mesh, the last entry is the quad count
+	std::array<uint32_t, s_sliceCount + 1> m_first{};
+	std::bitset<s_sliceCount> m_changed; // Rebuilt since the last Assemble
+
+	static void WriteQuad(const Quad &quad, MeshVertex *vertices);
+};
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+template <typename FaceLookUp>
+inline void ChunkMesher<Depth, Width, Height>::RebuildSlice(Cube::Face face, int slice, const FaceLookUp &faceAt)
+{
+	const glm::ivec3 size{Width, Height, Depth};
+	const FaceAxes axes = GetFaceAxes(face);
+	const int sizeU = size[axes.m_u];
+	const int sizeV = size[axes.m_v];
+
+	const int index = SliceIndex(face, slice);
+	std::vector<Quad> &quads = m_slices[index];
+	quads.clear();
+	m_changed.set(index);
+	m_mask.resize(sizeU * sizeV);
+
+	glm::ivec3 pos{0};
+	pos[axes.m_normal] = slice;
+	for (int v = 0; v < sizeV; ++v)
+	{
+		pos[axes.m_v] = v;
+		for (int u = 0; u < sizeU; ++u)
+		{
+			pos[axes.m_u] = u;
+			m_mask[v * sizeU + u] = faceAt(pos.x, pos.y, pos.z, face);
+		}
+	}
+
+	for (int v = 0; v < sizeV; ++v)
+	{
+		for (int u = 0; u < sizeU;)
+		{
+			const Cube::Type type = m_mask[v * sizeU + u];
+			if (type == Cube::Type::None)
+			{
+				++u;
+				continue;
+			}
+
+			int width = 1;
+			while (u + width < sizeU && m_mask[v * sizeU + u + width] == type)
+				++width;
+
+			int height = 1;
+			for (; v + height < sizeV; ++height)
+			{
+				const auto row = m_mask.begin() + (v + height) * sizeU + u;
+				if (std::any_of(row, row + width, [type](Cube::Type t) { return t != type; }))
+					break;
+			}
+
+			for (int dv = 0; dv < height; ++dv)
+			{
+				const auto row = m_mask.begin() + (v + dv) * sizeU + u;
+				std::fill(row, row + width, Cube::Type::None);
+			}
+
+			glm::ivec3 origin{0};
+			origin[axes.m_normal] = slice + (axes.m_positive ? 1 : 0);
+			origin[axes.m_u] = u;
+			origin[axes.m_v] = v;
+			quads.push_back(Quad{type, face, origin, width, height});
+			u += width;
+		}
+	}
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+template <typename FaceLookUp>
+inline void ChunkMesher<Depth, Width, Height>::RebuildAll(const FaceLookUp &faceAt)
+{
+	for (uint8_t f = 0; f < 6; ++f)
+	{
+		const Cube::Face face = static_cast<Cube::Face>(f);
+		for (int slice = 0; slice < SliceCount(face); ++slice)
+			RebuildSlice(face, slice, faceAt);
+	}
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline void ChunkMesher<Depth, Width, Height>::ClearSlice(Cube::Face face, int slice)
+{
+	const int index = SliceIndex(face, slice);
+	if (m_slices[index].empty())
+		return;
+	m_slices[index].clear();
+	m_changed.set(index);
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline const ChunkMesh &ChunkMesher<Depth, Width, Height>::Assemble()
+{
+	if (m_changed.none())
+		return m_mesh;
+
+	bool sameCounts = true;
+	for (int s = 0; s < s_sliceCount && sameCounts; ++s)
+		sameCounts = !m_changed.test(s) || m_slices[s].size() == m_first[s + 1] - m_first[s];
+
+	if (sameCounts)
+	{
+		for (int s = 0; s < s_sliceCount; ++s)
+		{
+			if (!m_changed.test(s))
+				continue;
+			MeshVertex *vertices = m_mesh.m_vertices.data() + m_first[s] * 4;
+			for (const Quad &quad : m_slices[s])
+			{
+				WriteQuad(quad, vertices);
+				vertices += 4;
+			}
+		}
+		m_changed.reset();
+		return m_mesh;
+	}
+
+	// Nowy układ: niezmienione warstwy kopiowane w całości, zmienione zapisywane od nowa
+	const uint32_t oldCount = m_first[s_sliceCount];
+	std::vector<MeshVertex> &vertices = m_spare;
+	std::array<uint32_t, s_sliceCount + 1> first;
+	first[0] = 0;
+	for (int s = 0; s < s_sliceCount; ++s)
+	{
+		const uint32_t count = m_changed.test(s) ? static_cast<uint32_t>(m_slices[s].size()) : m_first[s + 1] - m_first[s];
+		first[s + 1] = first[s] + count;
+	}
+	vertices.resize(static_cast<size_t>(first[s_sliceCount]) * 4);
+	for (int s = 0; s < s_sliceCount; ++s)
+	{
+		MeshVertex *out = vertices.data() + first[s] * 4;
+		if (!m_changed.test(s))
+		{
+			std::copy_n(m_mesh.m_vertices.data() + m_first[s] * 4, (first[s + 1] - first[s]) * 4, out);
+			continue;
+		}
+		for (const Quad &quad : m_slices[s])
+		{
+			WriteQuad(quad, out);
+			out += 4;
+		}
+	}
+	m_mesh.m_vertices.swap(vertices);
+	m_first = first;
+	m_changed.reset();
+
+	// Każdy czworokąt ma te same indeksy względem swojego pierwszego wierzchołka
+	const uint32_t quadCount = m_first[s_sliceCount];
+	m_mesh.m_indices.resize(static_cast<size_t>(quadCount) * 6);
+	static constexpr std::array<uint32_t, 6> s_pattern = {0, 1, 2, 2, 3, 0};
+	for (uint32_t q = oldCount; q < quadCount; ++q)
+	{
+		for (size_t i = 0; i < s_pattern.size(); ++i)
+			m_mesh.m_indices[q * 6 + i] = q * 4 + s_pattern[i];
+	}
+	return m_mesh;
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline void ChunkMesher<Depth, Width, Height>::WriteQuad(const Quad &quad, MeshVertex *vertices)
+{
+	// Counter-clockwise when looking at the face from outside the block: the
+	// corners of a face looking down its axis go the other way round
+	const FaceAxes axes = GetFaceAxes(quad.m_face);
+	const std::array<glm::ivec2, 4> positive = {
+		glm::ivec2(0, 0), glm::ivec2(quad.m_width, 0),
+		glm::ivec2(quad.m_width, quad.m_height), glm::ivec2(0, quad.m_height)};
+	const std::array<glm::ivec2, 4> negative = {positive[0], positive[3], positive[2], positive[1]};
+
+	for (const glm::ivec2 &corner : axes.m_positive ? positive : negative)
+	{
+		glm::ivec3 pos = quad.m_origin;
+		pos[axes.m_u] += corner.x;
+		pos[axes.m_v] += corner.y;
+		*vertices++ = MeshVertex{
+			static_cast<uint8_t>(pos.x), static_cast<uint8_t>(pos.y), static_cast<uint8_t>(pos.z),
+			static_cast<uint8_t>(quad.m_face),
+			static_cast<uint8_t>(corner.x), static_cast<uint8_t>(corner.y),
+			static_cast<uint8_t>(quad.m_type), 0};
+	}
+}
+
+// Builds the whole mesh in one go; see ChunkMesher for faceAt
+template <uint8_t Depth, uint8_t Width, uint8_t Height, typename FaceLookUp>
+ChunkMesh GreedyMesh(const FaceLookUp &faceAt)
+{
+	ChunkMesher<Depth, Width, Height> mesher;
+	mesher.RebuildAll(faceAt);
+	return mesher.Assemble();
+}
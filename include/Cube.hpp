@@ -1,40 +1,41 @@
 #pragma once
 #include <array>
-#include <string>
-#include <GL/glew.h>
+#include <cstddef>
+#include <cstdint>
 
 class Cube
 {
 public:
-  enum class Type
+  // One byte per block in chunk storage
+  enum class Type : uint8_t
   {
     None,
     Grass,
     Stone,
     Coord
   };
+  static constexpr size_t s_typeCount = static_cast<size_t>(Type::Coord) + 1;
 
-  Cube(const std::string &texturePath);
+  // Faces in the order they appear in s_vertices
+  enum class Face : uint8_t
+  {
+    Front,  // +z
+    Back,   // -z
+    Left,   // -x
+    Right,  // +x
+    Bottom, // -y
+    Top     // +y
+  };
 
-  Cube() = delete;
-  Cube(const Cube &) = delete;
-  Cube &operator=(const Cube &) = delete;
-  Cube(Cube &&) noexcept;
-  Cube &operator=(Cube &&) noexcept;
-  ~Cube();
+  // Block material: the layer of the palette's texture array used by a type
+  explicit Cube(uint8_t layer) : m_layer(layer) {}
 
-  GLuint Vbo() const { return m_vbo; }
-  GLuint Vao() const { return m_vao; }
-  void draw() const;
-  GLuint Texture() const { return m_texture; }
+  uint8_t Layer() const { return m_layer; }
+
+  static const std::array<float, 6 * 6 * 5> &Vertices() { return s_vertices; }
 
 private:
-  GLuint m_vbo{0};
-  GLuint m_vao{0};
-  GLuint m_ebo{0};
-  GLuint m_texture{0};
+  uint8_t m_layer{0};
 
   static std::array<float, 6 * 6 * 5> s_vertices;
-
-  GLuint createTexture(const std::string &texturePath);
 };
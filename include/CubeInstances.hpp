@@ -0,0 +1,47 @@
+#pragma once
+#include "Cube.hpp"
+
+#include <glm/glm.hpp>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Chunk-local offsets of the visible blocks of a chunk, kept in one list per
+// Cube::Type and used as per-instance data for glDrawArraysInstanced.
+// Single cells are patched in O(1), so edits never rebuild whole lists.
+class CubeInstances
+{
+public:
+  struct Offset
+  {
+    uint8_t m_x;
+    uint8_t m_y;
+    uint8_t m_z;
+    uint8_t m_type;
+  };
+
+  explicit CubeInstances(size_t cellCount);
+
+  // Moves the cell into the list of `type`; None takes it out of every list
+  void Set(size_t cell, const glm::ivec3 &position, Cube::Type type);
+
+  const std::vector<Offset> &Instances(Cube::Type type) const;
+  size_t Count() const;
+
+  // Lists changed since the last ClearDirty, whose GPU copy is stale
+  bool IsDirty(Cube::Type type) const;
+  void ClearDirty();
+
+private:
+  struct List
+  {
+    std::vector<Offset> m_offsets;
+    std::vector<uint32_t> m_cells;
+    bool m_dirty{false};
+  };
+
+  static constexpr uint32_t s_absent = UINT32_MAX;
+
+  std::array<List, Cube::s_typeCount> m_lists;
+  std::vector<uint32_t> m_slots; // Per cell: type << 24 | index in its list
+};
@@ -1,15 +1,38 @@
 #pragma once
 
 #include "Cube.hpp"
+#include "ShaderProgram.hpp"
 
+#include <GL/glew.h>
+#include <array>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
+// All block textures live in one GL_TEXTURE_2D_ARRAY and all cubes share one
+// VAO, so whole chunks are drawn without texture or vertex array switches.
 class CubePalette {
 public:
 	CubePalette();
+	CubePalette(const CubePalette &) = delete;
+	CubePalette &operator=(const CubePalette &) = delete;
+	~CubePalette();
 
 	const Cube& LookUp(Cube::Type type) const;
 
+	// Binds the texture array and the type -> layer table, once per frame
+	void Bind(ShaderProgram &shader) const;
+	// One cube per entry of instanceVbo (CubeInstances::Offset, 4 bytes each)
+	void DrawInstanced(GLuint instanceVbo, GLsizei count) const;
+
 private:
 	std::unordered_map<Cube::Type, Cube> m_palette;
-};
\ No newline at end of file
+	std::array<GLint, Cube::s_typeCount> m_layers{};
+	GLuint m_textureArray{0};
+	GLuint m_vao{0};
+	GLuint m_vbo{0};
+
+	// Layer i holds texturePaths[i]; one that cannot be loaded, or does not
+	// match the size of the first that can, becomes a placeholder layer
+	static GLuint createTextureArray(const std::vector<std::string> &texturePaths);
+};
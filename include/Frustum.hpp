@@ -0,0 +1,46 @@
+#pragma once
+#include "AABB.hpp"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// View frustum as the six planes of a view-projection matrix (Gribb &
+// Hartmann). Normals point inwards and have unit length, so Distance is in
+// world units.
+class Frustum
+{
+public:
+	enum class Side
+	{
+		Left,
+		Right,
+		Bottom,
+		Top,
+		Near,
+		Far
+	};
+
+	explicit Frustum(const glm::mat4 &viewProjection);
+
+	// (normal, d): dot(normal, point) + d >= 0 on the inner side
+	const glm::vec4 &Plane(Side side) const { return m_planes[static_cast<size_t>(side)]; }
+	float Distance(Side side, const glm::vec3 &point) const;
+
+	// False only when the box lies wholly outside one of the planes, so a box
+	// next to a frustum edge may pass while still out of view
+	bool Intersects(const AABB &box) const;
+	// Intersects for boxes.m_minX.size() boxes in SoA layout: visible[i] is 1
+	// when box i passes, 0 otherwise. Returns the number that pass. Same
+	// kernels and Path as the AABB batch tests, with identical results. Every
+	// box span and visible must have that size; otherwise nothing is read or
+	// written and 0 is returned (printing why to std::cerr).
+	size_t Intersects(const AABB::Boxes &boxes, std::span<uint8_t> visible) const;
+	size_t Intersects(const AABB::Boxes &boxes, std::span<uint8_t> visible, AABB::Path path) const;
+
+private:
+	std::array<glm::vec4, 6> m_planes;
+};
@@ -0,0 +1,49 @@
+#pragma once
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// GL_TIME_ELAPSED queries around parts of a frame. Results are read back a
+// few frames later, once the GPU has them, so nothing waits on the GPU; they
+// go to Profiler::RecordGpu. Time elapsed queries cannot nest, so a Begin
+// while another zone is open is ignored. Does nothing while the profiler is
+// off. Needs a live GL context.
+class GpuTimer
+{
+public:
+  GpuTimer() = default;
+  GpuTimer(const GpuTimer &) = delete;
+  GpuTimer &operator=(const GpuTimer &) = delete;
+  ~GpuTimer();
+
+  void Begin(const char *name);
+  void End();
+  // Once per frame: hands finished queries to the profiler
+  void Collect();
+
+  class Zone
+  {
+  public:
+    Zone(GpuTimer &timer, const char *name) : m_timer(timer) { m_timer.Begin(name); }
+    Zone(const Zone &) = delete;
+    Zone &operator=(const Zone &) = delete;
+    ~Zone() { m_timer.End(); }
+
+  private:
+    GpuTimer &m_timer;
+  };
+
+private:
+  struct Query
+  {
+    GLuint m_id;
+    const char *m_name;
+    uint64_t m_start; // Profiler::Now() at Begin
+  };
+
+  std::deque<Query> m_pending; // Oldest first, the order the GPU finishes them
+  std::vector<GLuint> m_free;
+  Query m_open{0, nullptr, 0};
+};
@@ -0,0 +1,30 @@
+#pragma once
+#include "CubeInstances.hpp"
+#include "CubePalette.hpp"
+
+#include <GL/glew.h>
+#include <vector>
+
+// GPU copy of the instance lists of one chunk, concatenated into one buffer
+// so the chunk is a single instanced draw
+class InstanceBuffer
+{
+public:
+  InstanceBuffer() = default;
+  InstanceBuffer(const InstanceBuffer &) = delete;
+  InstanceBuffer &operator=(const InstanceBuffer &) = delete;
+  InstanceBuffer(InstanceBuffer &&) noexcept;
+  InstanceBuffer &operator=(InstanceBuffer &&) noexcept;
+  ~InstanceBuffer();
+
+  // Re-uploads the lists if any of them changed and clears their dirty flags
+  void Upload(CubeInstances &instances);
+  void Draw(const CubePalette &palette) const;
+
+private:
+  GLuint m_vbo{0};
+  GLsizei m_count{0};
+  std::vector<CubeInstances::Offset> m_staging;
+
+  void Release();
+};
@@ -0,0 +1,56 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Thread pool with one job deque per worker. A worker takes its own newest
+// job first and, when it runs dry, steals the oldest job of another worker.
+// With zero threads every job runs inline on the submitting thread.
+class JobSystem
+{
+public:
+  using Job = std::function<void()>;
+
+  explicit JobSystem(size_t threadCount);
+  JobSystem(const JobSystem &) = delete;
+  JobSystem &operator=(const JobSystem &) = delete;
+  ~JobSystem();
+
+  // Jobs submitted from one of this pool's workers go to its own deque,
+  // others round-robin
+  void Submit(Job job);
+  // Runs body(0..count-1) and returns once all of them finished. The range
+  // is split into batches that the calling thread and idle workers take in
+  // turn; the caller only ever runs batches of its own call, so a long job
+  // queued by someone else cannot hold it up.
+  void ParallelFor(size_t count, const std::function<void(size_t)> &body);
+
+  size_t ThreadCount() const { return m_threads.size(); }
+  // Hardware threads minus the main one, at least one
+  static size_t DefaultThreadCount();
+
+private:
+  struct Worker
+  {
+    std::mutex m_mutex;
+    std::deque<Job> m_jobs;
+  };
+
+  std::vector<std::unique_ptr<Worker>> m_workers;
+  std::vector<std::thread> m_threads;
+  std::mutex m_wakeMutex;
+  std::condition_variable m_wake;
+  std::atomic<size_t> m_queued{0};
+  std::atomic<size_t> m_next{0};
+  bool m_stop{false};
+
+  bool TryRun(size_t worker);
+  bool Pop(size_t worker, Job &job);
+  void Run(size_t worker);
+};
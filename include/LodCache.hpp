@@ -0,0 +1,110 @@
+#pragma once
+#include "ChunkMesh.hpp"
+#include "MeshBuffer.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <unordered_map>
+
+// GPU meshes of chunks at reduced detail (Chunk::BuildLodMesh), built when
+// first drawn and kept within a budget of vertex and index bytes. When a new
+// mesh does not fit, the least recently drawn ones go first; meshes drawn in
+// the current frame stay. Each mesh remembers the chunk revision it was
+// built from and counts as missing once the chunk changes. A mesh that did
+// not fit is remembered too, so it is not built again until it could.
+class LodCache
+{
+public:
+	struct Key
+	{
+		glm::ivec2 m_coords; // Chunk
+		int m_level;
+
+		bool operator==(const Key &other) const { return m_coords == other.m_coords && m_level == other.m_level; }
+	};
+
+	// Keys have levels below levels
+	explicit LodCache(int levels, size_t budget = 16u << 20);
+
+	// Starts a frame: meshes drawn before it may be evicted again
+	void NextFrame()
+	{
+		++m_frame;
+		m_pinned = 0;
+	}
+	// nullptr when the mesh is not cached or was built from another revision
+	const MeshBuffer *Find(const Key &key, uint32_t revision);
+	// The mesh of this revision was refused by Insert and still would be, so
+	// building it again is wasted work
+	bool Refused(const Key &key, uint32_t revision);
+	// Uploads the mesh; nullptr (evicting nothing) when it does not fit the
+	// budget even after evicting everything not drawn this frame
+	const MeshBuffer *Insert(const Key &key, uint32_t revision, const ChunkMesh &mesh);
+	// Every level of a chunk, e.g. when it unloads
+	void Erase(const glm::ivec2 &coords);
+	// Every level of every chunk keep(coords) is false for, e.g. the ones no
+	// longer loaded; also chunks that were only ever drawn from this cache
+	template <typename Keep>
+	void Retain(const Keep &keep);
+
+	void SetBudget(size_t budget) { m_budget = budget; }
+	size_t Budget() const { return m_budget; }
+	size_t MemoryUsage() const { return m_used; }
+	size_t Size() const { return m_entries.size(); }
+
+private:
+	struct Entry
+	{
+		Key m_key;
+		uint32_t m_revision;
+		size_t m_bytes;
+		uint64_t m_frame; // Last drawn
+		MeshBuffer m_buffer;
+	};
+
+	struct Refusal
+	{
+		uint32_t m_revision;
+		size_t m_bytes;
+	};
+
+	struct KeyHash
+	{
+		size_t operator()(const Key &key) const
+		{
+			const uint64_t coords = (static_cast<uint64_t>(static_cast<uint32_t>(key.m_coords.x)) << 32) | static_cast<uint32_t>(key.m_coords.y);
+			return std::hash<uint64_t>{}(coords * 31 + static_cast<uint64_t>(key.m_level));
+		}
+	};
+
+	using List_t = std::list<Entry>;
+
+	int m_levels;
+	size_t m_budget;
+	size_t m_used{0};
+	size_t m_pinned{0}; // Bytes of meshes drawn this frame
+	uint64_t m_frame{0};
+	List_t m_entries; // Most recently drawn first
+	std::unordered_map<Key, List_t::iterator, KeyHash> m_index;
+	std::unordered_map<Key, Refusal, KeyHash> m_refused;
+
+	void Remove(List_t::iterator entry);
+};
+
+template <typename Keep>
+inline void LodCache::Retain(const Keep &keep)
+{
+	for (auto entry = m_entries.begin(); entry != m_entries.end();)
+	{
+		const auto next = std::next(entry);
+		if (!keep(entry->m_key.m_coords))
+			Remove(entry);
+		entry = next;
+	}
+	std::erase_if(m_refused, [&keep](const auto &refusal)
+				  { return !keep(refusal.first.m_coords); });
+}
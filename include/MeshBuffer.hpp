@@ -0,0 +1,30 @@
+#pragma once
+#include "ChunkMesh.hpp"
+
+#include <GL/glew.h>
+
+// GPU copy of a ChunkMesh. GL objects are created on the first Upload of a
+// non-empty mesh, so an empty MeshBuffer can be constructed (and given empty
+// meshes) without a GL context.
+class MeshBuffer
+{
+public:
+  MeshBuffer() = default;
+  MeshBuffer(const MeshBuffer &) = delete;
+  MeshBuffer &operator=(const MeshBuffer &) = delete;
+  MeshBuffer(MeshBuffer &&) noexcept;
+  MeshBuffer &operator=(MeshBuffer &&) noexcept;
+  ~MeshBuffer();
+
+  void Upload(const ChunkMesh &mesh);
+  // Expects the palette's texture array to be bound
+  void Draw() const;
+
+private:
+  GLuint m_vao{0};
+  GLuint m_vbo{0};
+  GLuint m_ebo{0};
+  GLsizei m_indexCount{0};
+
+  void Release();
+};
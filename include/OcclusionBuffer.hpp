@@ -0,0 +1,57 @@
+#pragma once
+#include "AABB.hpp"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <vector>
+
+// Small CPU depth buffer for occlusion culling. Occluders are boxes known to
+// be solid all the way through; their camera-facing faces are rasterised
+// with the depth of the nearest one kept per pixel (as 1 / w, so bigger is
+// nearer and it interpolates linearly on screen). A box is hidden when its
+// nearest corner is behind the stored depth at every pixel its screen
+// rectangle touches. Pixels take the occluder depth at their centre, so a
+// box may still peek out by under half a pixel at an occluder's silhouette.
+// Rows go 8 pixels at a time with AVX where available.
+class OcclusionBuffer
+{
+public:
+	// width is rounded up to a multiple of 8
+	explicit OcclusionBuffer(int width = 128, int height = 96);
+
+	// Starts a frame: no occluders, new camera
+	void Clear(const glm::mat4 &viewProjection);
+	// Boxes crossing the near plane are skipped, which only loses occlusion;
+	// so are boxes already hidden, so drawing near to far saves fill
+	void DrawOccluder(const AABB &box);
+	// False when the box is behind occluders at every pixel it touches
+	bool IsVisible(const AABB &box) const;
+
+	int Width() const { return m_width; }
+	int Height() const { return m_height; }
+	// 1 / w of the nearest occluder per pixel, 0 where there is none; rows
+	// bottom to top like the screen
+	const std::vector<float> &Depth() const { return m_depth; }
+	void SetPath(AABB::Path path) { m_path = path; }
+
+private:
+	struct Vertex
+	{
+		float m_x; // Pixels
+		float m_y;
+		float m_z; // 1 / w
+	};
+
+	int m_width;
+	int m_height;
+	std::vector<float> m_depth;
+	glm::mat4 m_viewProjection{1.0f};
+	AABB::Path m_path;
+
+	// False when a corner is not in front of the near plane
+	bool Project(const AABB &box, std::array<Vertex, 8> &corners) const;
+	bool IsVisible(const std::array<Vertex, 8> &corners) const;
+	// Counter-clockwise when facing the camera
+	void DrawFace(const std::array<Vertex, 4> &corners);
+};
@@ -0,0 +1,265 @@
+#pragma once
+#include "Cube.hpp"
+#include "Ray.hpp"
+#include "VoxelRay.hpp"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+
+// Which blocks of a Depth x Width x Height chunk are solid, as a two level
+// bitmask pyramid. A brick is 4x4x4 blocks packed into one 64-bit word; a
+// region is 4x4x4 bricks (16^3 blocks) with one bit per non-empty brick.
+// Set keeps both levels up to date in O(1), so queries can skip a whole
+// empty region or brick with a single test instead of visiting its blocks.
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+class Occupancy
+{
+public:
+	static constexpr int s_brickSize = 4;
+	static constexpr int s_regionSize = s_brickSize * 4;
+	// Sizes in bricks and regions; partial ones at the chunk edge stay partly unused
+	static glm::ivec3 Bricks() { return {s_bricksX, s_bricksY, s_bricksZ}; }
+	static glm::ivec3 Regions() { return {s_regionsX, s_regionsY, s_regionsZ}; }
+
+	struct TraceHit
+	{
+		glm::ivec3 m_cell;
+		Cube::Face m_face; // Face of m_cell the ray came in through
+		Ray::time_t m_time;
+	};
+
+	// data is in Chunk order: y-major, then x, then z
+	void Assign(std::span<const Cube::Type, Depth * Width * Height> data);
+	void Set(int x, int y, int z, bool solid);
+
+	bool IsSolid(int x, int y, int z) const { return (m_bricks[BrickIndex(x >> 2, y >> 2, z >> 2)] >> BitIndex(x, y, z)) & 1; }
+	bool IsEmpty() const;
+	// No solid block in the box of blocks [min, max], clamped to the chunk
+	bool IsEmpty(glm::ivec3 min, glm::ivec3 max) const;
+	// No solid block with the given coordinate along axis (0 = x, 1 = y, 2 = z)
+	bool IsLayerEmpty(int axis, int layer) const;
+	// One above the highest solid block, 0 when there is none
+	int Top() const;
+	// How high every block column of brick column (bx, bz) is solid from y = 0
+	// up without a gap; what lies below it is hidden from every side
+	int SolidHeight(int bx, int bz) const;
+
+	// First solid block along a ray in chunk-local coordinates, between
+	// minTime and maxTime: one bit test per block, and an empty brick (or an
+	// empty region around it) is crossed in a single step
+	bool Trace(const Ray &ray, Ray::time_t minTime, Ray::time_t maxTime, TraceHit &hit) const;
+
+private:
+	static constexpr int s_bricksX = (Width + 3) / 4, s_bricksY = (Height + 3) / 4, s_bricksZ = (Depth + 3) / 4;
+	static constexpr int s_regionsX = (s_bricksX + 3) / 4, s_regionsY = (s_bricksY + 3) / 4, s_regionsZ = (s_bricksZ + 3) / 4;
+	static constexpr int s_regionCount = s_regionsX * s_regionsY * s_regionsZ;
+
+	std::array<uint64_t, s_bricksX * s_bricksY * s_bricksZ> m_bricks{};		// Bit per block
+	std::array<uint64_t, s_regionsX * s_regionsY * s_regionsZ> m_regions{}; // Bit per non-empty brick
+
+	// Inside a brick or region the bits go y-major, then x, then z, like blocks in a chunk
+	static int BitIndex(int x, int y, int z) { return (y & 3) * 16 + (x & 3) * 4 + (z & 3); }
+	static size_t BrickIndex(int x, int y, int z) { return (static_cast<size_t>(y) * s_bricksX + x) * s_bricksZ + z; }
+	static size_t RegionIndex(int x, int y, int z) { return (static_cast<size_t>(y) * s_regionsX + x) * s_regionsZ + z; }
+};
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline void Occupancy<Depth, Width, Height>::Assign(std::span<const Cube::Type, Depth * Width * Height> data)
+{
+	m_bricks.fill(0);
+	m_regions.fill(0);
+
+	size_t index = 0;
+	for (int y = 0; y < Height; ++y)
+	{
+		for (int x = 0; x < Width; ++x)
+		{
+			for (int z = 0; z < Depth; ++z, ++index)
+			{
+				if (data[index] != Cube::Type::None)
+					m_bricks[BrickIndex(x >> 2, y >> 2, z >> 2)] |= uint64_t{1} << BitIndex(x, y, z);
+			}
+		}
+	}
+
+	for (int y = 0; y < s_bricksY; ++y)
+	{
+		for (int x = 0; x < s_bricksX; ++x)
+		{
+			for (int z = 0; z < s_bricksZ; ++z)
+			{
+				if (m_bricks[BrickIndex(x, y, z)] != 0)
+					m_regions[RegionIndex(x >> 2, y >> 2, z >> 2)] |= uint64_t{1} << BitIndex(x, y, z);
+			}
+		}
+	}
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline void Occupancy<Depth, Width, Height>::Set(int x, int y, int z, bool solid)
+{
+	uint64_t &brick = m_bricks[BrickIndex(x >> 2, y >> 2, z >> 2)];
+	const uint64_t bit = uint64_t{1} << BitIndex(x, y, z);
+	brick = solid ? brick | bit : brick & ~bit;
+
+	uint64_t &region = m_regions[RegionIndex(x >> 4, y >> 4, z >> 4)];
+	const uint64_t brickBit = uint64_t{1} << BitIndex(x >> 2, y >> 2, z >> 2);
+	region = brick != 0 ? region | brickBit : region & ~brickBit;
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline bool Occupancy<Depth, Width, Height>::IsEmpty() const
+{
+	return std::all_of(m_regions.begin(), m_regions.end(), [](uint64_t region)
+					   { return region == 0; });
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline bool Occupancy<Depth, Width, Height>::IsEmpty(glm::ivec3 min, glm::ivec3 max) const
+{
+	const glm::ivec3 size{Width, Height, Depth};
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		min[axis] = std::max(min[axis], 0);
+		max[axis] = std::min(max[axis], size[axis] - 1);
+		if (min[axis] > max[axis])
+			return true;
+	}
+
+	// Cegiełka po cegiełce; pusty region pomija wszystkie swoje naraz
+	for (int by = min.y >> 2; by <= max.y >> 2; ++by)
+	{
+		for (int bx = min.x >> 2; bx <= max.x >> 2; ++bx)
+		{
+			for (int bz = min.z >> 2; bz <= max.z >> 2; ++bz)
+			{
+				if (!((m_regions[RegionIndex(bx >> 2, by >> 2, bz >> 2)] >> BitIndex(bx, by, bz)) & 1))
+					continue;
+
+				// Maska bloków cegiełki leżących w pudełku
+				uint64_t mask = 0;
+				for (int y = std::max(min.y, by * 4); y <= std::min(max.y, by * 4 + 3); ++y)
+				{
+					for (int x = std::max(min.x, bx * 4); x <= std::min(max.x, bx * 4 + 3); ++x)
+					{
+						for (int z = std::max(min.z, bz * 4); z <= std::min(max.z, bz * 4 + 3); ++z)
+							mask |= uint64_t{1} << BitIndex(x, y, z);
+					}
+				}
+				if (m_bricks[BrickIndex(bx, by, bz)] & mask)
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline bool Occupancy<Depth, Width, Height>::IsLayerEmpty(int axis, int layer) const
+{
+	// Bity jednej warstwy w słowie cegiełki, dla x, y i z
+	static constexpr std::array<uint64_t, 3> s_layerMasks = {0x000F000F000F000Full, 0xFFFFull, 0x1111111111111111ull};
+	const uint64_t mask = s_layerMasks[axis] << (axis == 0 ? 4 : axis == 1 ? 16 : 1) * (layer & 3);
+
+	const glm::ivec3 bricks = Bricks();
+	glm::ivec3 brick{0};
+	const int a = axis == 0 ? 1 : 0;
+	const int b = axis == 2 ? 1 : 2;
+	brick[axis] = layer >> 2;
+	for (brick[a] = 0; brick[a] < bricks[a]; ++brick[a])
+	{
+		for (brick[b] = 0; brick[b] < bricks[b]; ++brick[b])
+		{
+			if (m_bricks[BrickIndex(brick.x, brick.y, brick.z)] & mask)
+				return false;
+		}
+	}
+	return true;
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline int Occupancy<Depth, Width, Height>::Top() const
+{
+	for (int y = Height - 1; y >= 0; --y)
+	{
+		if (!IsLayerEmpty(1, y))
+			return y + 1;
+	}
+	return 0;
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline int Occupancy<Depth, Width, Height>::SolidHeight(int bx, int bz) const
+{
+	// Kolumna cegiełek poza krawędzią chunku ma tylko część bloków
+	if ((bx + 1) * 4 > Width || (bz + 1) * 4 > Depth)
+		return 0;
+
+	int height = 0;
+	for (int by = 0; by < s_bricksY; ++by)
+	{
+		const uint64_t brick = m_bricks[BrickIndex(bx, by, bz)];
+		for (int layer = 0; layer < 4; ++layer, ++height)
+		{
+			// Warstwa cegiełki to 16 kolejnych bitów
+			if (((brick >> (16 * layer)) & 0xFFFF) != 0xFFFF)
+				return height;
+		}
+	}
+	return height;
+}
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height>
+inline bool Occupancy<Depth, Width, Height>::Trace(const Ray &ray, Ray::time_t minTime, Ray::time_t maxTime, TraceHit &hit) const
+{
+	// Zwykły przebieg po blokach, z testem bitu w słowie cegiełki. Słowo równe
+	// 0 to pusta cegiełka, a gdy pusty jest i jej region, cały region: przebieg
+	// opuszcza go jednym VoxelRay::Leave zamiast kroku na każdy blok. Osobny
+	// przebieg po cegiełkach kosztował więcej, niż dawał.
+	if (IsEmpty())
+		return false;
+
+	const glm::ivec3 blocks(s_bricksX * s_brickSize, s_bricksY * s_brickSize, s_bricksZ * s_brickSize);
+	const glm::ivec3 last(blocks.x - 1, blocks.y - 1, blocks.z - 1);
+	const auto outside = [&blocks](const glm::ivec3 &cell)
+	{ return static_cast<unsigned>(cell.x) >= static_cast<unsigned>(blocks.x) || static_cast<unsigned>(cell.y) >= static_cast<unsigned>(blocks.y) ||
+			 static_cast<unsigned>(cell.z) >= static_cast<unsigned>(blocks.z); };
+
+	VoxelRay walk(ray, minTime, maxTime, glm::ivec3(0), last);
+	while (true)
+	{
+		const glm::ivec3 cell = walk.Cell();
+		// Promień nie wraca do pudełka, z którego wyszedł
+		if (outside(cell))
+			return false;
+
+		const uint64_t brick = m_bricks[BrickIndex(cell.x >> 2, cell.y >> 2, cell.z >> 2)];
+		if (brick != 0)
+		{
+			if ((brick >> BitIndex(cell.x, cell.y, cell.z)) & 1)
+			{
+				hit.m_cell = cell;
+				hit.m_face = walk.EnteredFace();
+				hit.m_time = walk.Time();
+				return true;
+			}
+			if (!walk.Step())
+				return false;
+			continue;
+		}
+
+		// Z jednym regionem pusty region to pusty chunk, odrzucony na początku
+		int size = s_brickSize;
+		if constexpr (s_regionCount > 1)
+		{
+			if (m_regions[RegionIndex(cell.x >> 4, cell.y >> 4, cell.z >> 4)] == 0)
+				size = s_regionSize;
+		}
+		const glm::ivec3 low = cell / size * size;
+		if (!walk.Leave(low, low + glm::ivec3(size - 1)))
+			return false;
+	}
+}
@@ -1,14 +1,29 @@
 #pragma once
 #include <glm/glm.hpp>
 #include <array>
+#include <cstdint>
+#include <span>
 
 class PerlinNoise {
 public:
-	PerlinNoise();
-    PerlinNoise(float seed);
+	// Seed 0 is Ken Perlin's reference permutation, any other seed shuffles it
+	// with Random, so the table is the same on every platform
+	explicit PerlinNoise(uint64_t seed = 0);
 
 	float At(const glm::vec3& coords) const;
 
+	// Kernels behind AtBatch; BestPath is what the running CPU supports
+	enum class Path { Scalar, SSE41, AVX2 };
+	static Path BestPath();
+
+	// out[i] = At({xs[i], ys[i], zs[i]}), 4 (SSE4.1) or 8 (AVX2) samples at a
+	// time. The SIMD kernels repeat At's operations, so results are identical.
+	void AtBatch(std::span<const float> xs, std::span<const float> ys, std::span<const float> zs, std::span<float> out) const;
+	void AtBatch(std::span<const float> xs, std::span<const float> ys, std::span<const float> zs, std::span<float> out, Path path) const;
+
 private:
 	std::array<uint8_t, 256 * 2> m_permutations;
+	std::array<int32_t, 256> m_hashes; // m_permutations widened for SIMD gathers
+
+	void WidenHashes();
 };
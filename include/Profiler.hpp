@@ -0,0 +1,76 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+#include <string>
+
+// Frame profiler: scoped CPU zones kept in one ring buffer per thread, GPU
+// times (GpuTimer) on a track of their own, a rolling per-frame summary and
+// a Chrome trace export. Off by default; a zone of a disabled profiler costs
+// one relaxed load, and building with -DNO_PROFILING removes PROFILE_ZONE.
+// Times are nanoseconds since the program started.
+class Profiler
+{
+public:
+  struct Event
+  {
+    const char *m_name; // Must outlive the profiler: string literals
+    uint64_t m_start;
+    uint64_t m_duration;
+  };
+
+  // Newest events kept per thread
+  static constexpr size_t s_capacity = 1 << 15;
+  // Frames the summary spans
+  static constexpr size_t s_frameHistory = 120;
+
+  static void SetEnabled(bool enabled);
+  static bool Enabled() { return s_enabled.load(std::memory_order_relaxed); }
+  static uint64_t Now();
+
+  // Name of the calling thread's track in traces
+  static void SetThreadName(const std::string &name);
+  // Call at the top of each frame on the main thread; ends the previous
+  // frame with a "Frame" zone
+  static void BeginFrame();
+  static void Record(const char *name, uint64_t start, uint64_t duration);
+  // Only ever from one thread, the one with the GL context
+  static void RecordGpu(const char *name, uint64_t start, uint64_t duration);
+
+  // Per zone over the last complete frames: mean and max time per frame
+  // and calls per frame. Worker zones are summed over threads and nested
+  // zones count in their parents too.
+  static void PrintSummary(std::ostream &out);
+  // Everything still in the ring buffers, for chrome://tracing or
+  // ui.perfetto.dev. GPU zones start where the CPU issued them.
+  static bool WriteTrace(const std::filesystem::path &path);
+
+  class Zone
+  {
+  public:
+    explicit Zone(const char *name) : m_name(Enabled() ? name : nullptr), m_start(m_name ? Now() : 0) {}
+    Zone(const Zone &) = delete;
+    Zone &operator=(const Zone &) = delete;
+    ~Zone()
+    {
+      if (m_name)
+        Record(m_name, m_start, Now() - m_start);
+    }
+
+  private:
+    const char *m_name;
+    uint64_t m_start;
+  };
+
+private:
+  inline static std::atomic<bool> s_enabled{false};
+};
+
+#ifdef NO_PROFILING
+#define PROFILE_ZONE(name)
+#else
+#define PROFILE_ZONE_JOIN(a, b) a##b
+#define PROFILE_ZONE_NAME(line) PROFILE_ZONE_JOIN(profileZone, line)
+#define PROFILE_ZONE(name) Profiler::Zone PROFILE_ZONE_NAME(__LINE__)(name)
+#endif
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+
+// Counter-based random numbers: value n of a stream is Mix(key + n * golden),
+// a pure function of (seed, stream, n). Nothing depends on call order or on
+// the standard library, so a chunk regenerates identically on any thread, in
+// any order, with any compiler.
+class Random
+{
+public:
+	explicit Random(uint64_t seed, uint64_t stream = 0) : m_key(Mix(seed ^ Mix(stream + s_golden))) {}
+
+	// SplitMix64 finaliser
+	static constexpr uint64_t Mix(uint64_t x)
+	{
+		x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+		x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+		return x ^ (x >> 31);
+	}
+
+	// Value number counter of the stream with the given key, without a generator
+	static constexpr uint64_t At(uint64_t key, uint64_t counter) { return Mix(key + (counter + 1) * s_golden); }
+
+	uint64_t Next() { return At(m_key, m_counter++); }
+
+	// Uniform in [0, bound), no modulo bias (Lemire's multiply and reject)
+	uint32_t Below(uint32_t bound)
+	{
+		uint64_t product = (Next() >> 32) * bound;
+		if (static_cast<uint32_t>(product) < bound)
+		{
+			const uint32_t threshold = (0u - bound) % bound;
+			while (static_cast<uint32_t>(product) < threshold)
+				product = (Next() >> 32) * bound;
+		}
+		return static_cast<uint32_t>(product >> 32);
+	}
+
+	// Uniform in [0, 1), 24 bits
+	float NextFloat() { return static_cast<float>(Next() >> 40) * (1.0f / 16777216.0f); }
+
+	uint64_t Counter() const { return m_counter; }
+	void Seek(uint64_t counter) { m_counter = counter; }
+
+private:
+	static constexpr uint64_t s_golden = 0x9E3779B97F4A7C15ull;
+
+	uint64_t m_key;
+	uint64_t m_counter{0};
+};
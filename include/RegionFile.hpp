@@ -0,0 +1,80 @@
+#pragma once
+#include "Cube.hpp"
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+// One file holding s_regionSize x s_regionSize chunks:
+//   header    "MCRG", version, chunk size                      16 B
+//   table     (offset, length) per chunk, length 0 = not stored  8 KiB
+//   payloads  run-length encoded blocks: (type, LEB128 run) pairs
+// The file is memory-mapped and chunks decode straight from the mapping.
+// Write builds the whole new file next to the old one, syncs it and renames
+// it over, so a crash leaves either the old region or the new one.
+class RegionFile
+{
+public:
+	static constexpr int s_regionSize = 32;
+	static constexpr int s_chunkCount = s_regionSize * s_regionSize;
+
+	RegionFile(std::filesystem::path path, const glm::ivec3 &chunkSize);
+	RegionFile(const RegionFile &) = delete;
+	RegionFile &operator=(const RegionFile &) = delete;
+	~RegionFile();
+
+	// local is the chunk position inside the region, 0..s_regionSize-1.
+	// Returns false when the chunk is not stored or its data is damaged.
+	bool Read(const glm::ivec2 &local, std::span<Cube::Type> blocks) const;
+	bool Contains(const glm::ivec2 &local) const { return !Payload(LocalIndex(local)).empty(); }
+	// Stores the encoded chunks (by LocalIndex) and keeps every other one
+	bool Write(const std::unordered_map<int, std::vector<uint8_t>> &chunks);
+
+	static int LocalIndex(const glm::ivec2 &local) { return local.y * s_regionSize + local.x; }
+	static void Encode(std::span<const Cube::Type> blocks, std::vector<uint8_t> &out);
+	static bool Decode(std::span<const uint8_t> data, std::span<Cube::Type> blocks);
+
+private:
+	std::filesystem::path m_path;
+	glm::ivec3 m_chunkSize;
+	const uint8_t *m_data{nullptr};
+	size_t m_size{0};
+	bool m_valid{true}; // False when the file exists but is not a region of this chunk size
+
+	void Map();
+	void Unmap();
+	std::span<const uint8_t> Payload(int index) const;
+};
+
+// The region files of one world, r.<x>.<z>.region in a single directory.
+// Files are opened on first use and stay mapped.
+class RegionStore
+{
+public:
+	struct StoredChunk
+	{
+		glm::ivec2 m_coords;
+		std::span<const Cube::Type> m_blocks;
+	};
+
+	RegionStore(std::filesystem::path directory, const glm::ivec3 &chunkSize);
+
+	// false when the chunk was never saved
+	bool Load(const glm::ivec2 &coords, std::span<Cube::Type> blocks);
+	// Each region touched is rewritten once
+	bool Save(std::span<const StoredChunk> chunks);
+
+	static glm::ivec2 RegionCoords(const glm::ivec2 &coords) { return glm::ivec2(coords.x >> 5, coords.y >> 5); }
+	static glm::ivec2 LocalCoords(const glm::ivec2 &coords) { return glm::ivec2(coords.x & 31, coords.y & 31); }
+
+private:
+	std::filesystem::path m_directory;
+	glm::ivec3 m_chunkSize;
+	std::unordered_map<uint64_t, std::unique_ptr<RegionFile>> m_regions;
+
+	RegionFile &Region(const glm::ivec2 &region);
+};
@@ -1,12 +1,24 @@
 #pragma once
 #include <GL/glew.h>
 #include <glm/glm.hpp>
+#include <array>
+#include <cstdint>
 #include <string>
 #include <utility>
 
 class ShaderProgram {
 public:
-  ShaderProgram();
+  // Meshed draws packed chunk meshes, Instanced draws one Cube per block offset
+  enum class Variant { Meshed, Instanced };
+
+  // Uniforms set from C++; locations are looked up once, after linking
+  enum class Uniform : uint8_t { Model, BlockLayers, Blocks, Count };
+
+  // view/projection live in the "Camera" uniform block (see CameraBuffer),
+  // shared by every program through this binding point
+  static constexpr GLuint s_cameraBinding = 0;
+
+  explicit ShaderProgram(Variant variant = Variant::Meshed);
   ShaderProgram(const ShaderProgram &) = delete;
   ShaderProgram &operator=(const ShaderProgram &) = delete;
   ShaderProgram(ShaderProgram &&rhs) noexcept;
@@ -15,22 +27,30 @@ public:
 
   void use();
 
-  void setInt(const std::string_view name, int value);
-  void setMat4(const std::string_view name, const glm::mat4 &value);
-
   GLuint getProgramId() const { return programId; };
   std::pair<GLuint, GLuint> createVertexBufferObject();
+  // Deletes the buffers from createVertexBufferObject and the program
   void cleanUp(std::pair<GLuint, GLuint> vv);
-  void setUniform(const std::string &name, const glm::mat4 &matrix);
+  void setUniform(Uniform uniform, const glm::mat4 &matrix);
+  void setUniform(Uniform uniform, const glm::vec3 &vector);
+  void setUniform(Uniform uniform, float value);
+  void setUniform(Uniform uniform, GLint value);
+  void setUniform(Uniform uniform, const GLint *values, GLsizei count);
 
 private:
   GLuint createShader(const GLchar *shaderSource, GLenum shaderType);
   GLuint createProgram(GLuint vertexShader, GLuint fragmentShader,
                        GLuint geometryShader = 0);
-  GLuint programId{};
-  GLuint vertexShader;
-  GLuint fragmentShader;
+  void resolveUniforms();
+  GLint location(Uniform uniform) const { return m_locations[static_cast<size_t>(uniform)]; }
+
+  GLuint programId{}; // Owns no shaders: they are deleted once linked
+  std::array<GLint, static_cast<size_t>(Uniform::Count)> m_locations{};
+
+  static const std::array<const char *, static_cast<size_t>(Uniform::Count)> s_uniformNames;
 
   static std::string s_vertexShaderSource;
   static std::string s_fragmentShaderSource;
+  static std::string s_instancedVertexShaderSource;
+  static std::string s_instancedFragmentShaderSource;
 };
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// Bounded lock-free queue for exactly one producer and one consumer thread.
+// Each side caches the other's index and rereads it only when the queue
+// looks full (or empty), so the shared cache lines move rarely.
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+	// Producer only; false when full
+	bool Push(T &&value)
+	{
+		const size_t tail = m_tail.load(std::memory_order_relaxed);
+		if (tail - m_headCache == Capacity)
+		{
+			m_headCache = m_head.load(std::memory_order_acquire);
+			if (tail - m_headCache == Capacity)
+				return false;
+		}
+		m_items[tail & (Capacity - 1)] = std::move(value);
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer only; false when empty
+	bool Pop(T &value)
+	{
+		const size_t head = m_head.load(std::memory_order_relaxed);
+		if (head == m_tailCache)
+		{
+			m_tailCache = m_tail.load(std::memory_order_acquire);
+			if (head == m_tailCache)
+				return false;
+		}
+		value = std::move(m_items[head & (Capacity - 1)]);
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	std::array<T, Capacity> m_items;
+	alignas(64) std::atomic<size_t> m_head{0}; // Written by the consumer
+	size_t m_tailCache{0};
+	alignas(64) std::atomic<size_t> m_tail{0}; // Written by the producer
+	size_t m_headCache{0};
+};
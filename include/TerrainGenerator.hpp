@@ -0,0 +1,76 @@
+#pragma once
+#include "Cube.hpp"
+#include "PerlinNoise.hpp"
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Fills the blocks of one chunk. Blocks are laid out like Chunk::CoordsToIndex,
+// index = (y * size.x + x) * size.z + z with size = (Width, Height, Depth).
+// Chunks are generated on worker threads, so Generate must not modify the
+// generator, and its result may depend only on the seed and the chunk origin:
+// a chunk dropped from memory is regenerated, not stored.
+class TerrainGenerator
+{
+public:
+	explicit TerrainGenerator(uint64_t seed) : m_seed(seed) {}
+	virtual ~TerrainGenerator() = default;
+	virtual void Generate(const glm::ivec3 &size, int worldX, int worldZ, std::span<Cube::Type> blocks) const = 0;
+
+	uint64_t Seed() const { return m_seed; }
+
+private:
+	uint64_t m_seed;
+};
+
+// The original terrain: one octave of noise per column as its height, every
+// column at most one block above its left and front neighbour, grass on stone
+class HeightmapGenerator : public TerrainGenerator
+{
+public:
+	explicit HeightmapGenerator(uint64_t seed = 0);
+	void Generate(const glm::ivec3 &size, int worldX, int worldZ, std::span<Cube::Type> blocks) const override;
+
+private:
+	PerlinNoise m_noise;
+};
+
+struct TerrainSettings
+{
+	// Height field: fBm octaves blended with ridged noise
+	int m_octaves{4};
+	float m_frequency{0.02f};
+	float m_lacunarity{2.0f};
+	float m_gain{0.5f};
+	float m_ridged{0.35f};	   // 0 = fBm only, 1 = ridged only
+	float m_baseHeight{7.0f};  // In blocks
+	float m_heightScale{5.0f}; // Blocks above and below m_baseHeight
+	// 3D density: the surface is pushed up or down by up to m_overhang blocks
+	float m_overhangFrequency{0.08f};
+	float m_overhang{2.0f};
+	// Caves: tunnels where the cave noise is within m_caveWidth of its midpoint
+	float m_caveFrequency{0.1f};
+	float m_caveWidth{0.05f}; // 0 disables caves
+	float m_caveRoof{3.0f};	  // Rock kept above a cave, in blocks
+	int m_caveFloor{1};		  // Lowest layer a cave can reach
+	// 3D noise is sampled every m_latticeStep blocks and interpolated
+	int m_latticeStep{4};
+};
+
+// Configurable terrain: fBm/ridged heights plus a 3D density field for
+// overhangs and caves. The density is sampled on a coarse lattice and only in
+// cells whose bounds do not already prove them all air or all solid.
+class FractalGenerator : public TerrainGenerator
+{
+public:
+	explicit FractalGenerator(const TerrainSettings &settings = TerrainSettings(), uint64_t seed = 0);
+	void Generate(const glm::ivec3 &size, int worldX, int worldZ, std::span<Cube::Type> blocks) const override;
+
+private:
+	TerrainSettings m_settings;
+	PerlinNoise m_noise;
+
+	void FillHeights(int worldX, int worldZ, int width, int depth, std::vector<float> &heights) const;
+};
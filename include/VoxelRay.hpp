@@ -0,0 +1,135 @@
+#pragma once
+#include "Cube.hpp"
+#include "Ray.hpp"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Amanatides & Woo grid traversal: visits the unit cells a ray passes
+// through between minTime and maxTime, in order, each exactly once, with
+// one comparison and one addition per step.
+class VoxelRay
+{
+public:
+	VoxelRay(const Ray &ray, Ray::time_t minTime, Ray::time_t maxTime)
+		: VoxelRay(ray, minTime, maxTime, glm::ivec3(std::numeric_limits<int>::min()), glm::ivec3(std::numeric_limits<int>::max()))
+	{
+	}
+
+	// The first cell is clamped to [low, high], for a start on the boundary
+	// of a box whose cells are the only ones of interest
+	VoxelRay(const Ray &ray, Ray::time_t minTime, Ray::time_t maxTime, const glm::ivec3 &low, const glm::ivec3 &high)
+		: m_time(minTime), m_maxTime(maxTime)
+	{
+		const glm::vec3 start = ray.At(minTime);
+		const glm::vec3 direction = ray.Direction();
+		m_cell = glm::ivec3(glm::floor(start));
+		for (int axis = 0; axis < 3; ++axis)
+			m_cell[axis] = std::clamp(m_cell[axis], low[axis], high[axis]);
+
+		Ray::time_t lastCrossing = -std::numeric_limits<Ray::time_t>::infinity();
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (direction[axis] == 0.0f)
+			{
+				m_step[axis] = 0;
+				m_next[axis] = m_delta[axis] = std::numeric_limits<Ray::time_t>::infinity();
+				m_rate[axis] = 0.0f;
+				continue;
+			}
+
+			m_step[axis] = direction[axis] > 0.0f ? 1 : -1;
+			m_delta[axis] = std::abs(1.0f / direction[axis]);
+			m_rate[axis] = std::abs(direction[axis]);
+			const float boundary = static_cast<float>(m_step[axis] > 0 ? m_cell[axis] + 1 : m_cell[axis]);
+			m_next[axis] = minTime + (boundary - start[axis]) / direction[axis];
+
+			// Ostatnia granica przed minTime: przez nią promień wszedł do pierwszej komórki
+			const Ray::time_t crossed = m_next[axis] - m_delta[axis];
+			if (crossed > lastCrossing)
+			{
+				lastCrossing = crossed;
+				m_face = EntryFace(axis, m_step[axis] > 0);
+			}
+		}
+	}
+
+	glm::ivec3 Cell() const { return m_cell; }
+	// Time at which the ray enters Cell() (minTime for the first cell)
+	Ray::time_t Time() const { return m_time; }
+	// Face of Cell() the ray came in through
+	Cube::Face EnteredFace() const { return m_face; }
+	// Time at which the ray leaves Cell()
+	Ray::time_t ExitTime() const { return std::min(m_next.x, std::min(m_next.y, m_next.z)); }
+
+	// Moves to the next cell; false once it starts after maxTime
+	bool Step()
+	{
+		const int axis = m_next.x < m_next.y ? (m_next.x < m_next.z ? 0 : 2) : (m_next.y < m_next.z ? 1 : 2);
+		if (m_next[axis] > m_maxTime)
+			return false;
+
+		m_time = m_next[axis];
+		m_cell[axis] += m_step[axis];
+		m_next[axis] += m_delta[axis];
+		m_face = EntryFace(axis, m_step[axis] > 0);
+		return true;
+	}
+
+	// Moves straight to the first cell past the box [low, high] around Cell(),
+	// where as many Step calls would end up; false once that starts after maxTime
+	bool Leave(const glm::ivec3 &low, const glm::ivec3 &high)
+	{
+		glm::ivec3 count;
+		glm::vec3 leave;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			count[axis] = m_step[axis] > 0 ? high[axis] - m_cell[axis] + 1 : m_cell[axis] - low[axis] + 1;
+			leave[axis] = m_step[axis] == 0 ? m_next[axis] : m_next[axis] + static_cast<float>(count[axis] - 1) * m_delta[axis];
+		}
+		const int axis = leave.x < leave.y ? (leave.x < leave.z ? 0 : 2) : (leave.y < leave.z ? 1 : 2);
+		if (leave[axis] > m_maxTime)
+			return false;
+
+		// Na pozostałych osiach tyle granic, ile promień minął przed wyjściem
+		m_time = leave[axis];
+		for (int other = 0; other < 3; ++other)
+		{
+			if (other == axis || !(m_next[other] < m_time))
+				continue;
+			const int crossed = std::min(count[other] - 1, static_cast<int>(std::ceil((m_time - m_next[other]) * m_rate[other])));
+			m_cell[other] += m_step[other] * crossed;
+			m_next[other] += static_cast<float>(crossed) * m_delta[other];
+		}
+		m_cell[axis] += m_step[axis] * count[axis];
+		m_next[axis] = m_time + m_delta[axis];
+		m_face = EntryFace(axis, m_step[axis] > 0);
+		return true;
+	}
+
+private:
+	glm::ivec3 m_cell{0};
+	glm::ivec3 m_step{0};
+	glm::vec3 m_next{0.0f};	 // Time of the next boundary on each axis
+	glm::vec3 m_delta{0.0f}; // Time between boundaries on each axis
+	glm::vec3 m_rate{0.0f};	 // Boundaries per unit of time, 1 / m_delta
+	Ray::time_t m_time;
+	Ray::time_t m_maxTime;
+	Cube::Face m_face{Cube::Face::Top};
+
+	// Stepping towards +axis enters the next cell through its -axis face
+	static Cube::Face EntryFace(int axis, bool positive)
+	{
+		switch (axis)
+		{
+		case 0:
+			return positive ? Cube::Face::Left : Cube::Face::Right;
+		case 1:
+			return positive ? Cube::Face::Bottom : Cube::Face::Top;
+		default:
+			return positive ? Cube::Face::Back : Cube::Face::Front;
+		}
+	}
+};
@@ -1,94 +1,582 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <ostream>
+#include <unordered_map>
+#include <mutex>
+#include <span>
+#include <unordered_set>
 #include <vector>
 #include "Chunk.hpp"
+#include "JobSystem.hpp"
+#include "ChunkIO.hpp"
+#include "Frustum.hpp"
+#include "OcclusionBuffer.hpp"
+#include "Profiler.hpp"
 
-template <size_t chunkSize, size_t worldSize>
+// Chunk coordinates are world block coordinates divided by chunkSize (x, z)
+struct ChunkCoordsHash
+{
+    static uint64_t Key(const glm::ivec2 &coords)
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(coords.x)) << 32) |
+               static_cast<uint32_t>(coords.y);
+    }
+
+    size_t operator()(const glm::ivec2 &coords) const
+    {
+        return std::hash<uint64_t>{}(Key(coords));
+    }
+};
+
+// Unbounded world streamed around the camera. Chunks within loadRadius of the
+// camera's chunk are generated on demand and dropped once they leave it; at
+// most maxChunks are resident, nearest first.
+// Generation runs on the job system; finished chunks are linked into the
+// world on the main thread, then visibility and meshing of every changed
+// chunk run as one parallel batch per frame. Nothing here needs GL, so the
+// world runs headless; WorldRenderer draws it.
+template <size_t chunkSize>
 class World
 {
 public:
-    World()
+    using Chunk_t = Chunk<chunkSize, chunkSize, chunkSize>;
+
+    explicit World(int loadRadius = 2, size_t maxChunks = 64,
+                   size_t threadCount = JobSystem::DefaultThreadCount(),
+                   std::unique_ptr<TerrainGenerator> generator = std::make_unique<HeightmapGenerator>())
+        : m_loadRadius(loadRadius), m_maxChunks(maxChunks), m_generator(std::move(generator)), m_jobs(threadCount) {}
+
+    ~World() { Save(); }
+
+    // Edited chunks are written here when they unload and when the world is
+    // destroyed; chunks found here are loaded instead of generated. Disk
+    // access runs on the ChunkIO thread. Call before the first update.
+    void SetSaveDirectory(const std::filesystem::path &directory)
+    {
+        m_io = std::make_unique<ChunkIO>(directory, glm::ivec3(chunkSize));
+    }
+
+    // Queues every resident chunk edited since it was last saved
+    void Save()
+    {
+        for (const auto &[coords, chunk] : m_chunks)
+        {
+            if (chunk->IsModified())
+                Save(coords, *chunk);
+        }
+    }
+
+    // Chunks left by the last Cull, for drawing (WorldRenderer)
+    const std::vector<Chunk_t *> &Visible() const { return visible_chunks; }
+
+    // Pamięć bloków: płaska tablica (1 bajt na blok) kontra sekcje z paletą
+    void PrintMemoryReport(std::ostream &out) const
     {
-        int x{0}, y{0};
-        for (int i{0}; i < worldSize * worldSize; i++)
+        size_t compressed = 0;
+        size_t uniformSections = 0;
+        for (const auto &[coords, chunk] : m_chunks)
         {
-            // index = y * width + x;
-            y = i / worldSize; // Wiersz
-            x = i % worldSize; // Kolumna
-            m_chunks.push_back(Chunk<chunkSize, chunkSize, chunkSize>(glm::vec2(x * chunkSize, y * chunkSize), palette));
-            m_chunks.back().Generate(perlin, x * chunkSize, y * chunkSize); // Przekazujemy offset
+            compressed += chunk->Blocks().MemoryUsage();
+            uniformSections += chunk->Blocks().UniformSectionCount();
         }
-        m_chunk = &m_chunks.front();
+        const size_t flat = m_chunks.size() * sizeof(typename Chunk_t::FlattenData_t);
+        const size_t sections = m_chunks.size() * Chunk_t::Storage_t::s_sectionCount;
+
+        out << "Chunks: " << m_chunks.size() << " of " << m_maxChunks << (m_atChunkLimit ? ", limit reached" : "") << "\n"
+            << "Flat block storage: " << flat << " B\n"
+            << "Palette block storage: " << compressed << " B ("
+            << (flat ? 100.0 * compressed / flat : 0.0) << "% of flat)\n"
+            << "Uniform sections: " << uniformSections << " / " << sections << std::endl;
     };
 
-    void Draw(ShaderProgram &shader)
+    static glm::ivec2 ChunkCoords(const glm::vec3 &position)
     {
-        if (visible_chunks.empty())
-            return;
+        return glm::ivec2(static_cast<int>(std::floor(position.x / chunkSize)),
+                          static_cast<int>(std::floor(position.z / chunkSize)));
+    }
+
+    // Chunk at chunk coordinates, nullptr when it is not loaded
+    Chunk_t *ChunkAt(const glm::ivec2 &coords) const
+    {
+        auto it = m_chunks.find(coords);
+        return it != m_chunks.end() ? it->second.get() : nullptr;
+    }
 
-        for (auto chunk : visible_chunks)
+    // Doładowuje i zwalnia chunki, gdy kamera przejdzie do innego chunku.
+    // heading (the camera's front) decides which chunks are read ahead.
+    void updateVisibleChunks(const glm::vec3 &cameraPosition, const glm::vec3 &heading = glm::vec3(0.0f))
+    {
+        PROFILE_ZONE("World::updateVisibleChunks");
+        const glm::ivec2 center = ChunkCoords(cameraPosition);
+        const bool moved = !m_streamed || center != m_center;
+        m_center = center;
+        m_streamed = true;
+        const glm::vec2 flatHeading(heading.x, heading.z);
+        m_heading = glm::length(flatHeading) > 1e-3f ? glm::normalize(flatHeading) : glm::vec2(0.0f);
+        if (moved)
         {
-            chunk->Draw(shader);
+            Unload();
+            Load();
+            Prefetch();
         }
+
+        ReceiveIO();
+        if (Publish() || moved)
+            CollectResident();
+
+        UpdateChunks();
     };
 
-    void getChunk(glm::vec3 &cameraPosition)
+    // Blocks until every requested chunk is generated and published
+    void Flush()
     {
-        int x = std::floor(cameraPosition.x / chunkSize);
-        int y = std::floor(cameraPosition.z / chunkSize);
-        int index = y * worldSize + x;
-        if (index >= 0 || index < worldSize * worldSize)
+        PROFILE_ZONE("World::Flush");
+        while (!m_pending.empty())
         {
-            m_chunk = &m_chunks[index];
+            ReceiveIO();
+            if (!Publish())
+                std::this_thread::yield();
         }
-    };
+        CollectResident();
+        UpdateChunks();
+    }
 
-    void updateVisibleChunks(glm::vec3 &cameraPosition)
+    // Leaves only the chunks whose bounds intersect the view frustum for
+    // Draw and, with occlusion culling on, drops those hidden behind the
+    // solid ground of the others (OcclusionBuffer); until the next Cull a
+    // newly loaded chunk is drawn regardless. Returns the number of chunks
+    // kept.
+    size_t Cull(const glm::mat4 &viewProjection)
     {
-        getChunk(cameraPosition);
-        if (!m_chunk)
-            return;
-        auto chunks = getNeighbors(m_chunk->getOrigin());
-        chunks.push_back(m_chunk);
-        visible_chunks.assign(chunks.begin(), chunks.end());
+        PROFILE_ZONE("World::Cull");
+        const Frustum frustum(viewProjection);
+        const AABB::Boxes boxes{m_bounds[0], m_bounds[1], m_bounds[2], m_bounds[3], m_bounds[4], m_bounds[5]};
+        m_inView.resize(m_resident.size());
+        frustum.Intersects(boxes, m_inView);
+
+        visible_chunks.clear();
+        for (size_t i = 0; i < m_resident.size(); ++i)
+        {
+            if (m_inView[i])
+                visible_chunks.push_back(m_resident[i]);
+        }
+        if (!m_occlusionCulling)
+            return visible_chunks.size();
+
+        PROFILE_ZONE("World::Cull occlusion");
+        // Od najbliższych: zasłonięte już zasłaniające nie są rysowane
+        const glm::vec2 center = (glm::vec2(m_center) + 0.5f) * static_cast<float>(chunkSize);
+        const auto distance = [&center](const Chunk_t *chunk)
+        {
+            const glm::vec2 d = glm::vec2(chunk->Bounds().Min().x, chunk->Bounds().Min().z) + 0.5f * chunkSize - center;
+            return d.x * d.x + d.y * d.y;
+        };
+        std::sort(visible_chunks.begin(), visible_chunks.end(), [&distance](const Chunk_t *a, const Chunk_t *b)
+                  { return distance(a) < distance(b); });
+        m_occlusion.Clear(viewProjection);
+        for (const Chunk_t *chunk : visible_chunks)
+        {
+            for (const AABB &occluder : chunk->Occluders())
+                m_occlusion.DrawOccluder(occluder);
+        }
+        // Własne zasłaniające leżą w SolidBounds, nie bliżej niż jego najbliższy róg, więc chunk nie zasłoni sam siebie
+        std::erase_if(visible_chunks, [this](const Chunk_t *chunk)
+                      { return !m_occlusion.IsVisible(chunk->SolidBounds()); });
+        return visible_chunks.size();
+    }
+
+    // Off by default: over open terrain the occluders of the generated
+    // ground hide next to nothing and the buffer costs far more than the
+    // frustum test (bench "cull"). Worth turning on for closed scenes.
+    void SetOcclusionCulling(bool enabled) { m_occlusionCulling = enabled; }
+    bool OcclusionCulling() const { return m_occlusionCulling; }
+    const OcclusionBuffer &Occlusion() const { return m_occlusion; }
+
+    size_t VisibleCount() const { return visible_chunks.size(); }
+
+    size_t ChunkCount() const { return m_chunks.size(); }
+
+    // Chunk holding a world block and the block's coordinates inside it;
+    // nullptr above or below the world and in chunks that are not loaded
+    Chunk_t *ChunkAt(const glm::ivec3 &block, glm::ivec3 &local) const
+    {
+        if (block.y < 0 || block.y >= static_cast<int>(chunkSize))
+            return nullptr;
+        const glm::ivec2 coords = ChunkCoords(glm::vec3(block));
+        local = block - glm::ivec3(coords.x, 0, coords.y) * static_cast<int>(chunkSize);
+        return ChunkAt(coords);
+    }
+
+    struct RaycastHit
+    {
+        glm::ivec3 m_block; // World block coordinates
+        Chunk_t *m_chunk{nullptr}; // Owner of m_block, nullptr on a miss
+        glm::ivec3 m_local; // m_block inside m_chunk
+        Cube::Face m_face;  // Face of m_block the ray came in through
+        // Cell in front of m_face, where a placed block goes; the chunk is
+        // nullptr when that cell is outside the loaded world
+        glm::ivec3 m_placement;
+        Chunk_t *m_placementChunk{nullptr};
+        glm::ivec3 m_placementLocal;
+        Ray::time_t m_time;
     };
 
-public:
-    Chunk<chunkSize, chunkSize, chunkSize> *m_chunk;
+    // First solid block within maxDistance along the ray (in units of its
+    // direction). The walk goes chunk by chunk and each loaded chunk searches
+    // its own part of the ray, skipping empty bricks; chunks that are not
+    // loaded count as air.
+    bool Raycast(const Ray &ray, Ray::time_t maxDistance, RaycastHit &hit) const
+    {
+        hit.m_chunk = nullptr;
+        // Komórki promienia przeskalowanego o 1 / chunkSize to całe chunki
+        const float inverse = 1.0f / chunkSize;
+        VoxelRay chunks(Ray(ray.Origin() * inverse, ray.Direction() * inverse), 0.0f, maxDistance);
+        do
+        {
+            const glm::ivec3 cell = chunks.Cell();
+            if (cell.y != 0)
+                continue;
+
+            const glm::ivec2 coords(cell.x, cell.z);
+            Chunk_t *chunk = ChunkAt(coords);
+            typename Chunk_t::HitRecord record;
+            if (!chunk || chunk->Hit(ray, chunks.Time(), std::min(chunks.ExitTime(), maxDistance), record) != Ray::HitType::Hit)
+                continue;
+
+            hit.m_local = record.m_cubeIndex;
+            hit.m_block = record.m_cubeIndex + glm::ivec3(coords.x, 0, coords.y) * static_cast<int>(chunkSize);
+            hit.m_chunk = chunk;
+            hit.m_face = record.m_face;
+            hit.m_placement = hit.m_block + FaceNormal(hit.m_face);
+            hit.m_placementChunk = ChunkAt(hit.m_placement, hit.m_placementLocal);
+            hit.m_time = record.m_time;
+            return true;
+        } while (chunks.Step());
+
+        return false;
+    }
+
+    // Raycast for many rays at once on the job system, for tools and tests;
+    // misses leave m_chunk == nullptr. Returns the number of hits.
+    size_t Raycast(std::span<const Ray> rays, Ray::time_t maxDistance, std::span<RaycastHit> hits)
+    {
+        PROFILE_ZONE("World::Raycast batch");
+        const size_t batchSize = 256;
+        const size_t batches = (rays.size() + batchSize - 1) / batchSize;
+        std::atomic<size_t> count{0};
+        m_jobs.ParallelFor(batches, [&](size_t batch)
+                           {
+            size_t found = 0;
+            const size_t last = std::min(rays.size(), (batch + 1) * batchSize);
+            for (size_t i = batch * batchSize; i < last; ++i)
+                found += Raycast(rays[i], maxDistance, hits[i]) ? 1 : 0;
+            count.fetch_add(found, std::memory_order_relaxed); });
+        return count.load();
+    }
+
+    // Every chunk is a function of the seed and its coordinates alone, so the
+    // world looks the same whatever order chunks were generated in
+    uint64_t Seed() const { return m_generator->Seed(); }
+    // Random stream of one chunk, independent of all the others
+    Random ChunkRandom(const glm::ivec2 &coords) const { return Random(Seed(), ChunkCoordsHash::Key(coords)); }
 
 private:
-    CubePalette palette;
-    PerlinNoise perlin;
-    std::vector<Chunk<chunkSize, chunkSize, chunkSize>> m_chunks;
-    std::vector<Chunk<chunkSize, chunkSize, chunkSize> *> visible_chunks;
-
-    // Chunk<chunkSize, chunkSize, chunkSize> chunk(glm::vec2(0, 0), palette);
-    std::vector<Chunk<chunkSize, chunkSize, chunkSize> *> getNeighbors(glm::vec2 pos)
-    {
-        size_t nx;
-        size_t ny;
-        std::vector<Chunk<chunkSize, chunkSize, chunkSize> *> neighbors;
-        std::vector<std::pair<int, int>> directions = {
-            {-1, -1}, {0, -1}, {1, -1}, // górny rząd
-            {-1, 0},
-            {1, 0}, // środkowy rząd (bez środka)
-            {-1, 1},
-            {0, 1},
-            {1, 1} // dolny rząd
-        };
+    std::unordered_map<glm::ivec2, std::unique_ptr<Chunk_t>, ChunkCoordsHash> m_chunks;
+    std::vector<Chunk_t *> visible_chunks;
+    // Every resident chunk and its bounds in SoA layout (min x, y, z, max
+    // x, y, z) for the frustum test, rebuilt when chunks come or go
+    std::vector<Chunk_t *> m_resident;
+    std::array<std::vector<float>, 6> m_bounds;
+    std::vector<uint8_t> m_inView;
+    OcclusionBuffer m_occlusion;
+    bool m_occlusionCulling{false};
+    int m_loadRadius;
+    size_t m_maxChunks;
+    bool m_atChunkLimit{false}; // The last Load stopped at m_maxChunks
+    std::unique_ptr<TerrainGenerator> m_generator;
+    glm::ivec2 m_center{0};
+    glm::vec2 m_heading{0.0f};
+    bool m_streamed{false};
+
+    // Only with a save directory. Loads in flight, pending chunks waiting for
+    // one, and read-ahead answers for chunks not requested yet
+    std::unique_ptr<ChunkIO> m_io;
+    std::unordered_set<glm::ivec2, ChunkCoordsHash> m_requested;
+    std::unordered_set<glm::ivec2, ChunkCoordsHash> m_awaitingIO;
+    std::unordered_map<glm::ivec2, ChunkIO::Result, ChunkCoordsHash> m_prefetched;
+    static constexpr int s_prefetchDistance = 2; // Chunks ahead of the load radius
+
+    // Chunks handed to the job system, owned here until published
+    std::unordered_map<glm::ivec2, std::unique_ptr<Chunk_t>, ChunkCoordsHash> m_pending;
+    std::mutex m_generatedMutex;
+    std::vector<glm::ivec2> m_generated; // Finished by workers, not yet published
+    std::vector<Chunk_t *> m_dirty;
+    // Last member: workers are joined before the chunks they work on go away
+    JobSystem m_jobs;
+
+    inline static const std::array<std::pair<Cube::Face, glm::ivec2>, 4> s_sides = {{
+        {Cube::Face::Left, {-1, 0}},
+        {Cube::Face::Right, {1, 0}},
+        {Cube::Face::Back, {0, -1}},
+        {Cube::Face::Front, {0, 1}},
+    }};
+
+    bool InRadius(const glm::ivec2 &coords, int extra = 0) const
+    {
+        const glm::ivec2 d = coords - m_center;
+        return d.x * d.x + d.y * d.y <= (m_loadRadius + extra) * (m_loadRadius + extra);
+    }
+
+    // The blocks are copied, the write itself happens on the IO thread
+    void Save(const glm::ivec2 &coords, Chunk_t &chunk)
+    {
+        if (!m_io)
+            return;
+
+        ChunkIO::Blocks_t blocks(Chunk_t::s_blockCount);
+        chunk.Flatten(std::span<Cube::Type, Chunk_t::s_blockCount>(blocks));
+        m_io->Save(coords, std::move(blocks));
+        chunk.MarkSaved();
+        m_prefetched.erase(coords);
+    }
+
+    void Unload()
+    {
+        for (auto it = m_chunks.begin(); it != m_chunks.end();)
+        {
+            if (InRadius(it->first))
+            {
+                ++it;
+                continue;
+            }
 
-        for (auto [dx, dy] : directions)
+            if (it->second->IsModified())
+                Save(it->first, *it->second);
+
+            // Sąsiedzi tracą wskaźnik, ich brzeg staje się krawędzią świata
+            for (const auto &[face, offset] : s_sides)
+            {
+                if (Chunk_t *neighbour = ChunkAt(it->first + offset))
+                    neighbour->SetNeighbour(OppositeFace(face), nullptr);
+            }
+            it = m_chunks.erase(it);
+        }
+    }
+
+    void Load()
+    {
+        PROFILE_ZONE("World::Load");
+        // Najbliższe najpierw, żeby limit obcinał najdalsze
+        std::vector<glm::ivec2> missing;
+        for (int z = -m_loadRadius; z <= m_loadRadius; ++z)
+        {
+            for (int x = -m_loadRadius; x <= m_loadRadius; ++x)
+            {
+                const glm::ivec2 coords = m_center + glm::ivec2(x, z);
+                if (InRadius(coords) && !ChunkAt(coords) && !m_pending.count(coords))
+                    missing.push_back(coords);
+            }
+        }
+        std::sort(missing.begin(), missing.end(), [this](const glm::ivec2 &a, const glm::ivec2 &b)
+                  {
+            const glm::ivec2 da = a - m_center;
+            const glm::ivec2 db = b - m_center;
+            return da.x * da.x + da.y * da.y < db.x * db.x + db.y * db.y; });
+
+        // Komunikat raz, gdy limit zaczyna obcinać, a nie przy każdym ruchu kamery
+        const bool wasAtLimit = m_atChunkLimit;
+        m_atChunkLimit = false;
+        for (const glm::ivec2 &coords : missing)
         {
-            nx = (pos.x / chunkSize) + dx;
-            ny = (pos.y / chunkSize) + dy;
+            if (m_chunks.size() + m_pending.size() >= m_maxChunks)
+            {
+                if (!wasAtLimit)
+                    std::cerr << "World: resident chunk limit (" << m_maxChunks << ") reached" << std::endl;
+                m_atChunkLimit = true;
+                break;
+            }
+
+            // Chunk bez sąsiadów: wątek roboczy dotyka tylko jego własnych danych
+            const glm::ivec2 origin = coords * static_cast<int>(chunkSize);
+            Chunk_t *chunk = m_pending.emplace(coords, std::make_unique<Chunk_t>(glm::vec2(origin))).first->second.get();
+            if (!m_io)
+            {
+                Generate(coords, *chunk);
+                continue;
+            }
 
-            if (nx >= 0 && nx < worldSize && ny >= 0 && ny < worldSize)
+            // Bez czekania na dysk, jeśli odpowiedź przyszła już z wyprzedzeniem
+            auto prefetched = m_prefetched.find(coords);
+            if (prefetched != m_prefetched.end())
             {
-                size_t index = ny * worldSize + nx;
-                neighbors.push_back(&m_chunks[index]);
+                Fill(coords, *chunk, prefetched->second);
+                m_prefetched.erase(prefetched);
+                continue;
             }
+            m_awaitingIO.insert(coords);
+            if (m_requested.insert(coords).second)
+                m_io->Load(coords);
         }
+    }
 
-        return neighbors;
+    void Generate(const glm::ivec2 &coords, Chunk_t &chunk)
+    {
+        const glm::ivec2 origin = coords * static_cast<int>(chunkSize);
+        m_jobs.Submit([this, &chunk, coords, origin]
+                      {
+            chunk.Generate(*m_generator, origin.x, origin.y); // Przekazujemy offset
+            std::lock_guard<std::mutex> lock(m_generatedMutex);
+            m_generated.push_back(coords); });
     }
-};
+
+    // Saved chunks go from the IO thread's decode buffer straight into the
+    // chunk's storage, the rest are generated
+    void Fill(const glm::ivec2 &coords, Chunk_t &chunk, const ChunkIO::Result &result)
+    {
+        if (!result.m_found || result.m_blocks.size() != Chunk_t::s_blockCount)
+        {
+            Generate(coords, chunk);
+            return;
+        }
+
+        chunk.Assign(std::span<const Cube::Type, Chunk_t::s_blockCount>(result.m_blocks));
+        std::lock_guard<std::mutex> lock(m_generatedMutex);
+        m_generated.push_back(coords);
+    }
+
+    // Chunks about to enter the load radius along the heading are read
+    // ahead, so Load usually finds their answer ready
+    void Prefetch()
+    {
+        if (!m_io)
+            return;
+
+        for (auto it = m_prefetched.begin(); it != m_prefetched.end();)
+        {
+            if (InRadius(it->first, s_prefetchDistance + 1))
+                ++it;
+            else
+                it = m_prefetched.erase(it);
+        }
+
+        if (m_heading == glm::vec2(0.0f))
+            return;
+        for (int step = 1; step <= s_prefetchDistance; ++step)
+        {
+            const glm::ivec2 ahead = m_center + glm::ivec2(glm::round(m_heading * static_cast<float>(step)));
+            for (int z = -m_loadRadius; z <= m_loadRadius; ++z)
+            {
+                for (int x = -m_loadRadius; x <= m_loadRadius; ++x)
+                {
+                    const glm::ivec2 coords = ahead + glm::ivec2(x, z);
+                    if (x * x + z * z > m_loadRadius * m_loadRadius || InRadius(coords) ||
+                        m_requested.count(coords) || m_prefetched.count(coords))
+                        continue;
+                    m_requested.insert(coords);
+                    m_io->Load(coords);
+                }
+            }
+        }
+    }
+
+    void ReceiveIO()
+    {
+        if (!m_io)
+            return;
+
+        ChunkIO::Result result;
+        while (m_io->Poll(result))
+        {
+            const glm::ivec2 coords = result.m_coords;
+            m_requested.erase(coords);
+            if (!m_awaitingIO.erase(coords))
+            {
+                if (InRadius(coords, s_prefetchDistance + 1))
+                    m_prefetched[coords] = std::move(result);
+                continue;
+            }
+
+            auto it = m_pending.find(coords);
+            if (!InRadius(coords))
+            {
+                m_pending.erase(it); // Kamera już odeszła
+                continue;
+            }
+            Fill(coords, *it->second, result);
+        }
+    }
+
+    // Links finished chunks into the world; returns whether any was added
+    bool Publish()
+    {
+        std::vector<glm::ivec2> generated;
+        {
+            std::lock_guard<std::mutex> lock(m_generatedMutex);
+            generated.swap(m_generated);
+        }
+        if (generated.empty())
+            return false;
+
+        PROFILE_ZONE("World::Publish");
+
+        bool published = false;
+        for (const glm::ivec2 &coords : generated)
+        {
+            auto it = m_pending.find(coords);
+            std::unique_ptr<Chunk_t> chunk = std::move(it->second);
+            m_pending.erase(it);
+
+            // Kamera mogła już odejść
+            if (!InRadius(coords) || m_chunks.size() >= m_maxChunks)
+                continue;
+
+            for (const auto &[face, offset] : s_sides)
+            {
+                if (Chunk_t *neighbour = ChunkAt(coords + offset))
+                {
+                    chunk->SetNeighbour(face, neighbour);
+                    neighbour->SetNeighbour(OppositeFace(face), chunk.get());
+                }
+            }
+            m_chunks.emplace(coords, std::move(chunk));
+            published = true;
+        }
+        return published;
+    }
+
+    void CollectResident()
+    {
+        m_resident.clear();
+        for (auto &bounds : m_bounds)
+            bounds.clear();
+        for (const auto &[coords, chunk] : m_chunks)
+        {
+            const AABB &box = chunk->Bounds();
+            m_resident.push_back(chunk.get());
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                m_bounds[axis].push_back(box.Min()[axis]);
+                m_bounds[3 + axis].push_back(box.Max()[axis]);
+            }
+        }
+        visible_chunks = m_resident;
+    }
+
+    // Visibility and meshing of changed chunks. Blocks are only edited on the
+    // main thread, which waits here, so reading neighbours is safe.
+    void UpdateChunks()
+    {
+        PROFILE_ZONE("World::UpdateChunks");
+        m_dirty.clear();
+        for (const auto &[coords, chunk] : m_chunks)
+        {
+            if (chunk->NeedsUpdate())
+                m_dirty.push_back(chunk.get());
+        }
+        m_jobs.ParallelFor(m_dirty.size(), [this](size_t i)
+                           { m_dirty[i]->Update(); });
+    }
+};
\ No newline at end of file
@@ -0,0 +1,137 @@
+#pragma once
+#include "World.hpp"
+#include "CubePalette.hpp"
+#include "MeshBuffer.hpp"
+#include "InstanceBuffer.hpp"
+#include "LodCache.hpp"
+#include "ShaderProgram.hpp"
+#include "Profiler.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <array>
+#include <ostream>
+#include <unordered_map>
+
+enum class RenderMode
+{
+    Meshed,
+    Instanced
+};
+
+// GL side of a World: the block palette and the GPU copies of chunk meshes,
+// instance lists and level-of-detail meshes, keyed by chunk coordinates.
+// Needs a live GL context, which World itself never does.
+template <size_t chunkSize>
+class WorldRenderer
+{
+public:
+    using World_t = World<chunkSize>;
+    using Chunk_t = typename World_t::Chunk_t;
+
+    explicit WorldRenderer(size_t lodBudget = 16u << 20) : m_lod(Chunk_t::s_lodLevels, lodBudget) {}
+
+    // Draws the chunks left by World::Cull. Those far from the camera use a
+    // LOD mesh (LodLevel); a missing one is built here, at most a few per
+    // frame, and the chunk is drawn in full until then.
+    void Draw(World_t &world, ShaderProgram &shader, const glm::vec3 &cameraPosition, RenderMode mode = RenderMode::Meshed)
+    {
+        PROFILE_ZONE("WorldRenderer::Draw");
+        // Kopie GPU chunków już zwolnionych; siatki LOD osobno, bo chunk
+        // rysowany tylko z daleka nie ma wpisu w m_buffers
+        const auto loaded = [&world](const glm::ivec2 &coords)
+        { return world.ChunkAt(coords) != nullptr; };
+        std::erase_if(m_buffers, [&loaded](const auto &entry)
+                      { return !loaded(entry.first); });
+        m_lod.Retain(loaded);
+
+        if (world.Visible().empty())
+            return;
+
+        // Jedna tablica tekstur dla wszystkich chunków
+        m_palette.Bind(shader);
+        m_lod.NextFrame();
+        int builds = 0;
+        for (Chunk_t *chunk : world.Visible())
+        {
+            const glm::ivec2 coords = World_t::ChunkCoords(chunk->Bounds().Min());
+            const glm::mat4 model = glm::translate(glm::mat4(1.0f), chunk->Bounds().Min());
+            shader.setUniform(ShaderProgram::Uniform::Model, model);
+            chunk->Update();
+
+            if (mode == RenderMode::Instanced)
+            {
+                ChunkBuffers &buffers = m_buffers[coords];
+                buffers.m_instances.Upload(chunk->Instances());
+                buffers.m_instances.Draw(m_palette);
+                continue;
+            }
+
+            if (const int level = LodLevel(*chunk, cameraPosition); level > 0)
+            {
+                const LodCache::Key key{coords, level};
+                const MeshBuffer *lod = m_lod.Find(key, chunk->Revision());
+                // Siatka, która się nie zmieściła, nie jest budowana co klatkę od nowa
+                if (!lod && builds < s_lodBuildsPerFrame && !m_lod.Refused(key, chunk->Revision()))
+                {
+                    ++builds;
+                    lod = m_lod.Insert(key, chunk->Revision(), chunk->BuildLodMesh(level));
+                }
+                if (lod)
+                {
+                    lod->Draw();
+                    continue;
+                }
+            }
+
+            ChunkBuffers &buffers = m_buffers[coords];
+            if (!buffers.m_uploaded || chunk->MeshChanged())
+            {
+                buffers.m_mesh.Upload(chunk->AssembleMesh());
+                buffers.m_uploaded = true;
+            }
+            buffers.m_mesh.Draw();
+        }
+    }
+
+    // Level of detail for a chunk: l when the camera is at least
+    // distances[l - 1] blocks from the chunk's bounds
+    int LodLevel(const Chunk_t &chunk, const glm::vec3 &cameraPosition) const
+    {
+        const AABB &bounds = chunk.Bounds();
+        const glm::vec3 nearest(std::clamp(cameraPosition.x, bounds.Min().x, bounds.Max().x),
+                                std::clamp(cameraPosition.y, bounds.Min().y, bounds.Max().y),
+                                std::clamp(cameraPosition.z, bounds.Min().z, bounds.Max().z));
+        const float distance = glm::length(nearest - cameraPosition);
+        int level = 0;
+        while (level < static_cast<int>(m_lodDistances.size()) && distance >= m_lodDistances[level])
+            ++level;
+        return level;
+    }
+
+    // Increasing; infinity turns a level off
+    void SetLodDistances(const std::array<float, Chunk_t::s_lodLevels - 1> &distances) { m_lodDistances = distances; }
+    // Bytes of vertices and indices kept for LOD meshes
+    void SetLodBudget(size_t bytes) { m_lod.SetBudget(bytes); }
+
+    void PrintMemoryReport(std::ostream &out) const
+    {
+        out << "Chunk buffers: " << m_buffers.size() << "\n"
+            << "LOD meshes: " << m_lod.Size() << ", " << m_lod.MemoryUsage() << " B of " << m_lod.Budget() << " B" << std::endl;
+    }
+
+private:
+    struct ChunkBuffers
+    {
+        MeshBuffer m_mesh;
+        InstanceBuffer m_instances;
+        bool m_uploaded{false};
+    };
+
+    CubePalette m_palette;
+    std::unordered_map<glm::ivec2, ChunkBuffers, ChunkCoordsHash> m_buffers;
+    LodCache m_lod;
+    std::array<float, Chunk_t::s_lodLevels - 1> m_lodDistances{48.0f, 80.0f};
+    static constexpr int s_lodBuildsPerFrame = 4;
+};
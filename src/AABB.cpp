@@ -1,71 +1,308 @@
 #include "../include/AABB.hpp"
 
-AABB::AABB(const glm::vec3& min, const glm::vec3& max)
-	: m_min(min)
-	, m_max(max) {
-}
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include <iostream>
 
-using udword = unsigned int ;
-#define IR(x)	((udword&)x)
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define AABB_X86 1
+#endif
 
-Ray::HitType AABB::Hit(const Ray& ray, Ray::time_t minTime, Ray::time_t maxTime, HitRecord& record) const {
-	const float epsilon = 0.00001f;
-	const glm::vec3 origin = ray.Origin();
-	const glm::vec3 direction = ray.Direction();
+namespace {
+	constexpr float s_infinity = std::numeric_limits<float>::infinity();
 
-	bool inside = true;
-	glm::vec3 maxT{ -1.0f };
-	glm::vec3 coords{ 0.0f };
+	// Kolejność argumentów jak w minps/maxps, żeby wszystkie ścieżki dawały te same bity
+	inline float Lesser(float a, float b) {
+		return a < b ? a : b;
+	}
 
-	for (uint32_t i = 0; i < 3; i++) {
-		if (origin[i] < m_min[i]) {
-			coords[i] = m_min[i];
-			inside = false;
+	inline float Greater(float a, float b) {
+		return a > b ? a : b;
+	}
 
-			if (IR(direction[i])) {
-				maxT[i] = (m_min[i] - origin[i]) / direction[i];
-			}
-		} else if(origin[i] > m_max[i]) {
-			coords[i] = m_max[i];
-			inside = false;
+	// Times at which the ray crosses the two planes of one slab. A ray parallel
+	// to the slab gives +-inf, or 0 * inf = NaN when it starts on a plane;
+	// then the slab does not limit it at all. Outside the slab both times are
+	// the same infinity, so a hit also needs enter < inf and exit > -inf.
+	inline void Slab(float origin, float inverse, float min, float max, float& nearTime, float& farTime) {
+		const float t0 = (min - origin) * inverse;
+		const float t1 = (max - origin) * inverse;
+		const bool ordered = t0 == t0 && t1 == t1;
+		nearTime = ordered ? Lesser(t0, t1) : -s_infinity;
+		farTime = ordered ? Greater(t0, t1) : s_infinity;
+	}
 
-			if (IR(direction[i])) {
-				maxT[i] = (m_max[i] - origin[i]) / direction[i];
+	// A NaN in the ray makes it miss everything. The batch kernels get the same
+	// result by testing such rays up to a NaN maxTime, which no time is <=.
+	inline bool Valid(const glm::vec3& origin, const glm::vec3& direction) {
+		for (int i = 0; i < 3; i++) {
+			if (std::isnan(origin[i]) || std::isnan(direction[i])) {
+				return false;
 			}
 		}
+		return true;
 	}
 
-	uint32_t axisIndex = static_cast<uint32_t>(Axis::x);
+	inline bool Overlaps(float enter, float exit) {
+		return enter <= exit && enter < s_infinity && exit > -s_infinity;
+	}
 
-	if (inside) {
-		coords = (m_min + m_max) / 2.0f;
+	// Entry time, infinity on a miss
+	inline float SlabTest(const glm::vec3& origin, const glm::vec3& inverse, const glm::vec3& min, const glm::vec3& max,
+		float minTime, float maxTime) {
+		glm::vec3 nearTime, farTime;
+		for (int i = 0; i < 3; i++) {
+			Slab(origin[i], inverse[i], min[i], max[i], nearTime[i], farTime[i]);
+		}
+		const float enter = Greater(Greater(nearTime.x, nearTime.y), Greater(nearTime.z, minTime));
+		const float exit = Lesser(Lesser(farTime.x, farTime.y), Lesser(farTime.z, maxTime));
+		return Overlaps(enter, exit) ? enter : s_infinity;
+	}
 
-		record.m_time = maxT[axisIndex];
-		record.m_point = coords;
-		record.m_axis = static_cast<Axis>(axisIndex);
-		return Ray::HitType::Hit;
+#ifdef AABB_X86
+	// Compare masks are all ones or all zeros, so and/andnot/or is the select
+	__attribute__((target("sse4.1"))) inline void SlabSSE(__m128 origin, __m128 inverse, __m128 min, __m128 max, __m128& nearTime, __m128& farTime) {
+		const __m128 t0 = _mm_mul_ps(_mm_sub_ps(min, origin), inverse);
+		const __m128 t1 = _mm_mul_ps(_mm_sub_ps(max, origin), inverse);
+		const __m128 ordered = _mm_cmpord_ps(t0, t1);
+		nearTime = _mm_or_ps(_mm_and_ps(ordered, _mm_min_ps(t0, t1)), _mm_andnot_ps(ordered, _mm_set1_ps(-s_infinity)));
+		farTime = _mm_or_ps(_mm_and_ps(ordered, _mm_max_ps(t0, t1)), _mm_andnot_ps(ordered, _mm_set1_ps(s_infinity)));
 	}
-	
-	if (maxT.y > maxT[axisIndex]) axisIndex = static_cast<uint32_t>(Axis::y);
-	if (maxT.z > maxT[axisIndex]) axisIndex = static_cast<uint32_t>(Axis::z);
 
-	if (static_cast<uint32_t>(maxT[axisIndex]) & 0x80000000
-		|| maxT[axisIndex] > maxTime 
-		|| maxT[axisIndex] < minTime) {
-		return Ray::HitType::Miss;
+	// Writes 4 entry times, returns the hit mask
+	__attribute__((target("sse4.1"))) inline int SlabTestSSE(const __m128 origin[3], const __m128 inverse[3], const __m128 min[3], const __m128 max[3],
+		__m128 minTime, __m128 maxTime, float* times) {
+		__m128 nearTime[3], farTime[3];
+		for (int i = 0; i < 3; i++) {
+			SlabSSE(origin[i], inverse[i], min[i], max[i], nearTime[i], farTime[i]);
+		}
+		const __m128 enter = _mm_max_ps(_mm_max_ps(nearTime[0], nearTime[1]), _mm_max_ps(nearTime[2], minTime));
+		const __m128 exit = _mm_min_ps(_mm_min_ps(farTime[0], farTime[1]), _mm_min_ps(farTime[2], maxTime));
+		const __m128 hit = _mm_and_ps(_mm_cmple_ps(enter, exit),
+			_mm_and_ps(_mm_cmplt_ps(enter, _mm_set1_ps(s_infinity)), _mm_cmpgt_ps(exit, _mm_set1_ps(-s_infinity))));
+		_mm_storeu_ps(times, _mm_or_ps(_mm_and_ps(hit, enter), _mm_andnot_ps(hit, _mm_set1_ps(s_infinity))));
+		return _mm_movemask_ps(hit);
 	}
 
-	for (uint32_t i = 0; i < 3; i++) {
-		if (i != axisIndex) {
-			coords[i] = origin[i] + maxT[axisIndex] * direction[i];
-			if (coords[i] < m_min[i] - epsilon || coords[i] > m_max[i] + epsilon) {
-				return Ray::HitType::Miss;
-			}
+	__attribute__((target("avx"))) inline void SlabAVX(__m256 origin, __m256 inverse, __m256 min, __m256 max, __m256& nearTime, __m256& farTime) {
+		const __m256 t0 = _mm256_mul_ps(_mm256_sub_ps(min, origin), inverse);
+		const __m256 t1 = _mm256_mul_ps(_mm256_sub_ps(max, origin), inverse);
+		const __m256 ordered = _mm256_cmp_ps(t0, t1, _CMP_ORD_Q);
+		nearTime = _mm256_or_ps(_mm256_and_ps(ordered, _mm256_min_ps(t0, t1)), _mm256_andnot_ps(ordered, _mm256_set1_ps(-s_infinity)));
+		farTime = _mm256_or_ps(_mm256_and_ps(ordered, _mm256_max_ps(t0, t1)), _mm256_andnot_ps(ordered, _mm256_set1_ps(s_infinity)));
+	}
+
+	__attribute__((target("avx"))) inline int SlabTestAVX(const __m256 origin[3], const __m256 inverse[3], const __m256 min[3], const __m256 max[3],
+		__m256 minTime, __m256 maxTime, float* times) {
+		__m256 nearTime[3], farTime[3];
+		for (int i = 0; i < 3; i++) {
+			SlabAVX(origin[i], inverse[i], min[i], max[i], nearTime[i], farTime[i]);
+		}
+		const __m256 enter = _mm256_max_ps(_mm256_max_ps(nearTime[0], nearTime[1]), _mm256_max_ps(nearTime[2], minTime));
+		const __m256 exit = _mm256_min_ps(_mm256_min_ps(farTime[0], farTime[1]), _mm256_min_ps(farTime[2], maxTime));
+		const __m256 hit = _mm256_and_ps(_mm256_cmp_ps(enter, exit, _CMP_LE_OQ),
+			_mm256_and_ps(_mm256_cmp_ps(enter, _mm256_set1_ps(s_infinity), _CMP_LT_OQ), _mm256_cmp_ps(exit, _mm256_set1_ps(-s_infinity), _CMP_GT_OQ)));
+		_mm256_storeu_ps(times, _mm256_or_ps(_mm256_and_ps(hit, enter), _mm256_andnot_ps(hit, _mm256_set1_ps(s_infinity))));
+		return _mm256_movemask_ps(hit);
+	}
+
+	__attribute__((target("sse4.1"))) size_t BoxesSSE(const Ray& ray, float minTime, float maxTime, const AABB::Boxes& boxes, float* times, size_t count) {
+		const glm::vec3 inverse = 1.0f / ray.Direction();
+		const __m128 o[3] = { _mm_set1_ps(ray.Origin().x), _mm_set1_ps(ray.Origin().y), _mm_set1_ps(ray.Origin().z) };
+		const __m128 inv[3] = { _mm_set1_ps(inverse.x), _mm_set1_ps(inverse.y), _mm_set1_ps(inverse.z) };
+		size_t hits = 0;
+		for (size_t i = 0; i < count; i += 4) {
+			const __m128 min[3] = { _mm_loadu_ps(&boxes.m_minX[i]), _mm_loadu_ps(&boxes.m_minY[i]), _mm_loadu_ps(&boxes.m_minZ[i]) };
+			const __m128 max[3] = { _mm_loadu_ps(&boxes.m_maxX[i]), _mm_loadu_ps(&boxes.m_maxY[i]), _mm_loadu_ps(&boxes.m_maxZ[i]) };
+			hits += __builtin_popcount(SlabTestSSE(o, inv, min, max, _mm_set1_ps(minTime), _mm_set1_ps(maxTime), times + i));
+		}
+		return hits;
+	}
+
+	__attribute__((target("avx"))) size_t BoxesAVX(const Ray& ray, float minTime, float maxTime, const AABB::Boxes& boxes, float* times, size_t count) {
+		const glm::vec3 inverse = 1.0f / ray.Direction();
+		const __m256 o[3] = { _mm256_set1_ps(ray.Origin().x), _mm256_set1_ps(ray.Origin().y), _mm256_set1_ps(ray.Origin().z) };
+		const __m256 inv[3] = { _mm256_set1_ps(inverse.x), _mm256_set1_ps(inverse.y), _mm256_set1_ps(inverse.z) };
+		size_t hits = 0;
+		for (size_t i = 0; i < count; i += 8) {
+			const __m256 min[3] = { _mm256_loadu_ps(&boxes.m_minX[i]), _mm256_loadu_ps(&boxes.m_minY[i]), _mm256_loadu_ps(&boxes.m_minZ[i]) };
+			const __m256 max[3] = { _mm256_loadu_ps(&boxes.m_maxX[i]), _mm256_loadu_ps(&boxes.m_maxY[i]), _mm256_loadu_ps(&boxes.m_maxZ[i]) };
+			hits += __builtin_popcount(SlabTestAVX(o, inv, min, max, _mm256_set1_ps(minTime), _mm256_set1_ps(maxTime), times + i));
+		}
+		return hits;
+	}
+
+	__attribute__((target("sse4.1"))) size_t RaysSSE(const AABB& box, float minTime, float maxTime, const AABB::Rays& rays, float* times, size_t count) {
+		const __m128 min[3] = { _mm_set1_ps(box.Min().x), _mm_set1_ps(box.Min().y), _mm_set1_ps(box.Min().z) };
+		const __m128 max[3] = { _mm_set1_ps(box.Max().x), _mm_set1_ps(box.Max().y), _mm_set1_ps(box.Max().z) };
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 nan = _mm_set1_ps(std::numeric_limits<float>::quiet_NaN());
+		size_t hits = 0;
+		for (size_t i = 0; i < count; i += 4) {
+			const __m128 o[3] = { _mm_loadu_ps(&rays.m_originX[i]), _mm_loadu_ps(&rays.m_originY[i]), _mm_loadu_ps(&rays.m_originZ[i]) };
+			const __m128 d[3] = { _mm_loadu_ps(&rays.m_directionX[i]), _mm_loadu_ps(&rays.m_directionY[i]), _mm_loadu_ps(&rays.m_directionZ[i]) };
+			const __m128 inv[3] = { _mm_div_ps(one, d[0]), _mm_div_ps(one, d[1]), _mm_div_ps(one, d[2]) };
+			const __m128 valid = _mm_and_ps(_mm_and_ps(_mm_cmpord_ps(o[0], d[0]), _mm_cmpord_ps(o[1], d[1])), _mm_cmpord_ps(o[2], d[2]));
+			const __m128 until = _mm_or_ps(_mm_and_ps(valid, _mm_set1_ps(maxTime)), _mm_andnot_ps(valid, nan));
+			hits += __builtin_popcount(SlabTestSSE(o, inv, min, max, _mm_set1_ps(minTime), until, times + i));
+		}
+		return hits;
+	}
+
+	__attribute__((target("avx"))) size_t RaysAVX(const AABB& box, float minTime, float maxTime, const AABB::Rays& rays, float* times, size_t count) {
+		const __m256 min[3] = { _mm256_set1_ps(box.Min().x), _mm256_set1_ps(box.Min().y), _mm256_set1_ps(box.Min().z) };
+		const __m256 max[3] = { _mm256_set1_ps(box.Max().x), _mm256_set1_ps(box.Max().y), _mm256_set1_ps(box.Max().z) };
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 nan = _mm256_set1_ps(std::numeric_limits<float>::quiet_NaN());
+		size_t hits = 0;
+		for (size_t i = 0; i < count; i += 8) {
+			const __m256 o[3] = { _mm256_loadu_ps(&rays.m_originX[i]), _mm256_loadu_ps(&rays.m_originY[i]), _mm256_loadu_ps(&rays.m_originZ[i]) };
+			const __m256 d[3] = { _mm256_loadu_ps(&rays.m_directionX[i]), _mm256_loadu_ps(&rays.m_directionY[i]), _mm256_loadu_ps(&rays.m_directionZ[i]) };
+			const __m256 inv[3] = { _mm256_div_ps(one, d[0]), _mm256_div_ps(one, d[1]), _mm256_div_ps(one, d[2]) };
+			const __m256 valid = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(o[0], d[0], _CMP_ORD_Q), _mm256_cmp_ps(o[1], d[1], _CMP_ORD_Q)),
+				_mm256_cmp_ps(o[2], d[2], _CMP_ORD_Q));
+			const __m256 until = _mm256_or_ps(_mm256_and_ps(valid, _mm256_set1_ps(maxTime)), _mm256_andnot_ps(valid, nan));
+			hits += __builtin_popcount(SlabTestAVX(o, inv, min, max, _mm256_set1_ps(minTime), until, times + i));
+		}
+		return hits;
+	}
+#endif
+
+	size_t BoxesScalar(const Ray& ray, float minTime, float maxTime, const AABB::Boxes& boxes, float* times, size_t first, size_t count) {
+		const glm::vec3 inverse = 1.0f / ray.Direction();
+		size_t hits = 0;
+		for (size_t i = first; i < count; i++) {
+			const glm::vec3 min(boxes.m_minX[i], boxes.m_minY[i], boxes.m_minZ[i]);
+			const glm::vec3 max(boxes.m_maxX[i], boxes.m_maxY[i], boxes.m_maxZ[i]);
+			times[i] = SlabTest(ray.Origin(), inverse, min, max, minTime, maxTime);
+			hits += times[i] != s_infinity ? 1 : 0;
+		}
+		return hits;
+	}
+
+	size_t RaysScalar(const AABB& box, float minTime, float maxTime, const AABB::Rays& rays, float* times, size_t first, size_t count) {
+		size_t hits = 0;
+		for (size_t i = first; i < count; i++) {
+			const glm::vec3 origin(rays.m_originX[i], rays.m_originY[i], rays.m_originZ[i]);
+			const glm::vec3 direction(rays.m_directionX[i], rays.m_directionY[i], rays.m_directionZ[i]);
+			const float until = Valid(origin, direction) ? maxTime : std::numeric_limits<float>::quiet_NaN();
+			times[i] = SlabTest(origin, 1.0f / direction, box.Min(), box.Max(), minTime, until);
+			hits += times[i] != s_infinity ? 1 : 0;
+		}
+		return hits;
+	}
+
+	// Every span of a batch has to hold one value per entry of times
+	bool Sized(std::initializer_list<std::span<const float>> spans, size_t count) {
+		const bool sized = std::all_of(spans.begin(), spans.end(), [count](std::span<const float> span) { return span.size() == count; });
+		if (!sized) {
+			std::cerr << "AABB: batch spans do not match " << count << " times" << std::endl;
 		}
+		return sized;
+	}
+}
+
+AABB::AABB(const glm::vec3& min, const glm::vec3& max)
+	: m_min(min)
+	, m_max(max) {
+}
+
+AABB::Path AABB::BestPath() {
+#ifdef AABB_X86
+	static const Path s_best = __builtin_cpu_supports("avx") ? Path::AVX
+		: __builtin_cpu_supports("sse4.1") ? Path::SSE41 : Path::Scalar;
+	return s_best;
+#else
+	return Path::Scalar;
+#endif
+}
+
+Ray::HitType AABB::Hit(const Ray& ray, Ray::time_t minTime, Ray::time_t maxTime, HitRecord& record) const {
+	if (!Valid(ray.Origin(), ray.Direction())) {
+		return Ray::HitType::Miss;
+	}
+	const glm::vec3 inverse = 1.0f / ray.Direction();
+	glm::vec3 nearTime, farTime;
+	for (int i = 0; i < 3; i++) {
+		Slab(ray.Origin()[i], inverse[i], m_min[i], m_max[i], nearTime[i], farTime[i]);
+	}
+
+	const float enter = Greater(Greater(nearTime.x, nearTime.y), Greater(nearTime.z, minTime));
+	const float exit = Lesser(Lesser(farTime.x, farTime.y), Lesser(farTime.z, maxTime));
+	if (!Overlaps(enter, exit)) {
+		return Ray::HitType::Miss;
 	}
 
-	record.m_time = maxT[axisIndex];
-	record.m_point = coords;
-	record.m_axis = static_cast<Axis>(axisIndex);
+	const int axis = nearTime.x >= nearTime.y ? (nearTime.x >= nearTime.z ? 0 : 2) : (nearTime.y >= nearTime.z ? 1 : 2);
+	record.m_time = enter;
+	record.m_point = ray.At(enter);
+	record.m_axis = static_cast<Axis>(axis);
 	return Ray::HitType::Hit;
 }
+
+bool AABB::Clip(const Ray& ray, Ray::time_t& minTime, Ray::time_t& maxTime) const {
+	if (!Valid(ray.Origin(), ray.Direction())) {
+		return false;
+	}
+	const glm::vec3 inverse = 1.0f / ray.Direction();
+	glm::vec3 nearTime, farTime;
+	for (int i = 0; i < 3; i++) {
+		Slab(ray.Origin()[i], inverse[i], m_min[i], m_max[i], nearTime[i], farTime[i]);
+	}
+
+	minTime = Greater(Greater(nearTime.x, nearTime.y), Greater(nearTime.z, minTime));
+	maxTime = Lesser(Lesser(farTime.x, farTime.y), Lesser(farTime.z, maxTime));
+	return Overlaps(minTime, maxTime);
+}
+
+size_t AABB::Hit(const Ray& ray, Ray::time_t minTime, Ray::time_t maxTime, const Boxes& boxes, std::span<Ray::time_t> times) {
+	return Hit(ray, minTime, maxTime, boxes, times, BestPath());
+}
+
+size_t AABB::Hit(const Ray& ray, Ray::time_t minTime, Ray::time_t maxTime, const Boxes& boxes, std::span<Ray::time_t> times, Path path) {
+	const size_t count = times.size();
+	if (!Sized({ boxes.m_minX, boxes.m_minY, boxes.m_minZ, boxes.m_maxX, boxes.m_maxY, boxes.m_maxZ }, count)) {
+		return 0;
+	}
+	if (!Valid(ray.Origin(), ray.Direction())) {
+		std::fill(times.begin(), times.end(), s_infinity);
+		return 0;
+	}
+	size_t done = 0;
+	size_t hits = 0;
+#ifdef AABB_X86
+	if (path == Path::AVX) {
+		done = count & ~size_t(7);
+		hits = BoxesAVX(ray, minTime, maxTime, boxes, times.data(), done);
+	} else if (path == Path::SSE41) {
+		done = count & ~size_t(3);
+		hits = BoxesSSE(ray, minTime, maxTime, boxes, times.data(), done);
+	}
+#endif
+	return hits + BoxesScalar(ray, minTime, maxTime, boxes, times.data(), done, count);
+}
+
+size_t AABB::Hit(const Rays& rays, Ray::time_t minTime, Ray::time_t maxTime, std::span<Ray::time_t> times) const {
+	return Hit(rays, minTime, maxTime, times, BestPath());
+}
+
+size_t AABB::Hit(const Rays& rays, Ray::time_t minTime, Ray::time_t maxTime, std::span<Ray::time_t> times, Path path) const {
+	const size_t count = times.size();
+	if (!Sized({ rays.m_originX, rays.m_originY, rays.m_originZ, rays.m_directionX, rays.m_directionY, rays.m_directionZ }, count)) {
+		return 0;
+	}
+	size_t done = 0;
+	size_t hits = 0;
+#ifdef AABB_X86
+	if (path == Path::AVX) {
+		done = count & ~size_t(7);
+		hits = RaysAVX(*this, minTime, maxTime, rays, times.data(), done);
+	} else if (path == Path::SSE41) {
+		done = count & ~size_t(3);
+		hits = RaysSSE(*this, minTime, maxTime, rays, times.data(), done);
+	}
+#endif
+	return hits + RaysScalar(*this, minTime, maxTime, rays, times.data(), done, count);
+}
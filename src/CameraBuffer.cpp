@@ -0,0 +1,50 @@
+#include "../include/CameraBuffer.hpp"
+#include <utility>
+
+CameraBuffer::CameraBuffer(CameraBuffer &&rhs) noexcept
+    : m_ubo(std::exchange(rhs.m_ubo, 0)) {}
+
+CameraBuffer &CameraBuffer::operator=(CameraBuffer &&rhs) noexcept
+{
+  if (&rhs == this)
+  {
+    return *this;
+  }
+
+  Release();
+  m_ubo = std::exchange(rhs.m_ubo, 0);
+
+  return *this;
+}
+
+CameraBuffer::~CameraBuffer()
+{
+  Release();
+}
+
+void CameraBuffer::Release()
+{
+  if (m_ubo != 0)
+    glDeleteBuffers(1, &m_ubo);
+  m_ubo = 0;
+}
+
+void CameraBuffer::Update(const glm::mat4 &view, const glm::mat4 &projection)
+{
+  const Block block{view, projection};
+
+  if (m_ubo == 0)
+  {
+    glGenBuffers(1, &m_ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(Block), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, ShaderProgram::s_cameraBinding, m_ubo);
+  }
+  else
+  {
+    glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+  }
+
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Block), &block);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
@@ -0,0 +1,190 @@
+#include "../include/ChunkIO.hpp"
+#include "../include/Profiler.hpp"
+#include <iostream>
+
+ChunkIO::ChunkIO(std::filesystem::path directory, const glm::ivec3 &chunkSize)
+	: m_store(std::move(directory), chunkSize), m_chunkSize(chunkSize), m_thread(&ChunkIO::Run, this)
+{
+}
+
+ChunkIO::~ChunkIO()
+{
+	// Wyniki nikt już nie odbierze, więc zwalniamy ich kolejkę: inaczej wątek
+	// IO czekałby na miejsce w niej, a my na miejsce w kolejce żądań
+	Result dropped;
+	while (!m_overflow.empty())
+	{
+		FlushOverflow();
+		while (m_results.Pop(dropped))
+		{
+		}
+		std::this_thread::yield();
+	}
+
+	m_stop.store(true, std::memory_order_release);
+	m_signal.fetch_add(1, std::memory_order_release);
+	m_signal.notify_one();
+	m_thread.join();
+}
+
+void ChunkIO::Load(const glm::ivec2 &coords)
+{
+	Push(Request{coords, false, {}});
+}
+
+void ChunkIO::Save(const glm::ivec2 &coords, Blocks_t blocks)
+{
+	Push(Request{coords, true, std::move(blocks)});
+}
+
+bool ChunkIO::Poll(Result &result)
+{
+	FlushOverflow();
+	return m_results.Pop(result);
+}
+
+void ChunkIO::Push(Request request)
+{
+	// Kolejność musi się zgadzać, więc nic nie omija zaległych żądań
+	FlushOverflow();
+	if (!m_overflow.empty() || !m_requests.Push(std::move(request)))
+	{
+		m_overflow.push_back(std::move(request));
+		return;
+	}
+	m_signal.fetch_add(1, std::memory_order_release);
+	m_signal.notify_one();
+}
+
+void ChunkIO::FlushOverflow()
+{
+	bool pushed = false;
+	while (!m_overflow.empty() && m_requests.Push(std::move(m_overflow.front())))
+	{
+		m_overflow.pop_front();
+		pushed = true;
+	}
+	if (pushed)
+	{
+		m_signal.fetch_add(1, std::memory_order_release);
+		m_signal.notify_one();
+	}
+}
+
+void ChunkIO::Run()
+{
+	Profiler::SetThreadName("ChunkIO");
+	bool stopping = false;
+	while (true)
+	{
+		// Stop czytany przed opróżnieniem kolejki: po nim żadne żądanie już nie przyjdzie
+		const bool stop = m_stop.load(std::memory_order_acquire);
+		const uint32_t signal = m_signal.load(std::memory_order_acquire);
+		if (stop && !stopping)
+		{
+			// Ostatnia próba dla regionów, których zapis się nie udał
+			stopping = true;
+			for (auto &[region, retry] : m_failed)
+				retry = Clock::time_point::min();
+		}
+		if (Serve(stopping))
+			continue;
+		if (stop)
+		{
+			if (!m_unsaved.empty())
+				std::cerr << "ChunkIO: " << m_unsaved.size() << " edited chunks are lost, their regions cannot be written" << std::endl;
+			return;
+		}
+		// Czekające ponowne próby nie dostaną sygnału, więc tylko drzemka
+		if (!m_failed.empty())
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		else
+			m_signal.wait(signal, std::memory_order_acquire);
+	}
+}
+
+bool ChunkIO::Serve(bool stopping)
+{
+	// Odczyty od razu, bo na nie czeka gra; zapisy czekają w m_unsaved,
+	// gdzie nowsza wersja chunku zastępuje starszą
+	bool served = false;
+	Request request;
+	while (m_requests.Pop(request))
+	{
+		served = true;
+		const uint64_t key = Key(request.m_coords);
+		if (request.m_save)
+		{
+			m_unsaved[key] = std::move(request);
+			continue;
+		}
+
+		Result result;
+		result.m_coords = request.m_coords;
+		auto unsaved = m_unsaved.find(key);
+		if (unsaved != m_unsaved.end())
+		{
+			result.m_found = true;
+			result.m_blocks = unsaved->second.m_blocks;
+		}
+		else
+		{
+			PROFILE_ZONE("ChunkIO load");
+			result.m_blocks.resize(static_cast<size_t>(m_chunkSize.x) * m_chunkSize.y * m_chunkSize.z);
+			result.m_found = m_store.Load(request.m_coords, result.m_blocks);
+			if (!result.m_found)
+				result.m_blocks.clear();
+		}
+
+		// Wątek główny odbiera wyniki co klatkę; przy zamykaniu nikt już nie czeka
+		while (!m_results.Push(std::move(result)) && !m_stop.load(std::memory_order_acquire))
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	if (served || m_unsaved.empty())
+		return served;
+
+	// Nic nie czeka na odczyt: jeden region naraz, potem znowu kolejka.
+	// Region, którego zapis się nie udał, czeka do czasu ponownej próby
+	const Clock::time_point now = Clock::now();
+	const Request *next = nullptr;
+	for (const auto &[key, item] : m_unsaved)
+	{
+		auto failed = m_failed.find(Key(RegionStore::RegionCoords(item.m_coords)));
+		if (failed == m_failed.end() || failed->second <= now)
+		{
+			next = &item;
+			break;
+		}
+	}
+	if (!next)
+		return false;
+
+	const glm::ivec2 region = RegionStore::RegionCoords(next->m_coords);
+	std::vector<RegionStore::StoredChunk> writes;
+	std::vector<uint64_t> written;
+	for (const auto &[key, item] : m_unsaved)
+	{
+		if (RegionStore::RegionCoords(item.m_coords) != region)
+			continue;
+		writes.push_back({item.m_coords, item.m_blocks});
+		written.push_back(key);
+	}
+	PROFILE_ZONE("ChunkIO save region");
+	if (!m_store.Save(writes))
+	{
+		// Chunki zostają w m_unsaved, a odczyty dalej je stamtąd dostają
+		m_failed[Key(region)] = stopping ? Clock::time_point::max() : now + s_retryDelay;
+		if (!stopping)
+			std::cerr << "ChunkIO: " << written.size() << " chunks of region " << region.x << ", " << region.y << " not saved, trying again later" << std::endl;
+		return true;
+	}
+	m_failed.erase(Key(region));
+	for (uint64_t key : written)
+		m_unsaved.erase(key);
+	return true;
+}
+
+uint64_t ChunkIO::Key(const glm::ivec2 &coords)
+{
+	return (static_cast<uint64_t>(static_cast<uint32_t>(coords.x)) << 32) | static_cast<uint32_t>(coords.y);
+}
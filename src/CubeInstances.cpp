@@ -0,0 +1,59 @@
+#include "../include/CubeInstances.hpp"
+
+CubeInstances::CubeInstances(size_t cellCount) : m_slots(cellCount, s_absent) {}
+
+void CubeInstances::Set(size_t cell, const glm::ivec3 &position, Cube::Type type)
+{
+  const uint32_t slot = m_slots[cell];
+  if (slot != s_absent)
+  {
+    const size_t current = slot >> 24;
+    if (current == static_cast<size_t>(type))
+      return;
+
+    // Swap-remove: the last instance of the list takes the freed slot
+    List &list = m_lists[current];
+    const uint32_t index = slot & 0xFFFFFF;
+    list.m_offsets[index] = list.m_offsets.back();
+    list.m_cells[index] = list.m_cells.back();
+    m_slots[list.m_cells[index]] = slot;
+    list.m_offsets.pop_back();
+    list.m_cells.pop_back();
+    list.m_dirty = true;
+    m_slots[cell] = s_absent;
+  }
+
+  if (type == Cube::Type::None)
+    return;
+
+  List &list = m_lists[static_cast<size_t>(type)];
+  m_slots[cell] = static_cast<uint32_t>(type) << 24 | static_cast<uint32_t>(list.m_offsets.size());
+  list.m_offsets.push_back(Offset{static_cast<uint8_t>(position.x), static_cast<uint8_t>(position.y),
+                                  static_cast<uint8_t>(position.z), static_cast<uint8_t>(type)});
+  list.m_cells.push_back(static_cast<uint32_t>(cell));
+  list.m_dirty = true;
+}
+
+const std::vector<CubeInstances::Offset> &CubeInstances::Instances(Cube::Type type) const
+{
+  return m_lists[static_cast<size_t>(type)].m_offsets;
+}
+
+size_t CubeInstances::Count() const
+{
+  size_t count = 0;
+  for (const List &list : m_lists)
+    count += list.m_offsets.size();
+  return count;
+}
+
+bool CubeInstances::IsDirty(Cube::Type type) const
+{
+  return m_lists[static_cast<size_t>(type)].m_dirty;
+}
+
+void CubeInstances::ClearDirty()
+{
+  for (List &list : m_lists)
+    list.m_dirty = false;
+}
@@ -1,17 +1,158 @@
 #include "../include/CubePalette.hpp"
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <iostream>
+
+namespace
+{
+    constexpr unsigned s_placeholderSize = 16;
+
+    // Magenta and black checks, hard to mistake for a real block
+    sf::Image Placeholder(const sf::Vector2u &size)
+    {
+        sf::Image image;
+        image.create(size.x, size.y, sf::Color::Magenta);
+        for (unsigned y = 0; y < size.y; ++y)
+        {
+            for (unsigned x = 0; x < size.x; ++x)
+            {
+                if ((x / 4 + y / 4) % 2 == 1)
+                    image.setPixel(x, y, sf::Color::Black);
+            }
+        }
+        return image;
+    }
+}
 
 CubePalette::CubePalette()
 {
-    Cube grass("../assets/grass.jpg");
-    Cube stone("../assets/stone.jpg");
-    Cube coord("../assets/grass_debug.jpg");
+    const std::array<std::pair<Cube::Type, std::string>, 3> textures = {{
+        {Cube::Type::Grass, "../assets/grass.jpg"},
+        {Cube::Type::Stone, "../assets/stone.jpg"},
+        {Cube::Type::Coord, "../assets/grass_debug.jpg"},
+    }};
+
+    // Każdy plik dekodowany raz, typy z tym samym plikiem dzielą warstwę
+    std::vector<std::string> files;
+    for (const auto &[type, path] : textures)
+    {
+        auto file = std::find(files.begin(), files.end(), path);
+        const uint8_t layer = static_cast<uint8_t>(file - files.begin());
+        if (file == files.end())
+            files.push_back(path);
+
+        m_palette.insert(std::pair<Cube::Type, Cube>(type, Cube(layer)));
+        m_layers[static_cast<size_t>(type)] = layer;
+    }
+
+    m_textureArray = createTextureArray(files);
+
+    const auto &vertices = Cube::Vertices();
+    glGenVertexArrays(1, &m_vao);
+    glGenBuffers(1, &m_vbo);
 
-    m_palette.insert(std::pair<Cube::Type, Cube>(Cube::Type::Stone, std::move(stone)));
-    m_palette.insert(std::pair<Cube::Type, Cube>(Cube::Type::Grass, std::move(grass)));
-    m_palette.insert(std::pair<Cube::Type, Cube>(Cube::Type::Coord, std::move(coord)));
+    glBindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float),
+                 vertices.data(), GL_STATIC_DRAW);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float),
+                          (void *)0); // Pozycja
+    glEnableVertexAttribArray(0);
+
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float),
+                          (void *)(3 * sizeof(float))); // Tekstura
+    glEnableVertexAttribArray(1);
+
+    glVertexAttribDivisor(2, 1); // Przesunięcie instancji, bufor podpinany przy rysowaniu
+    glEnableVertexAttribArray(2);
+
+    glBindVertexArray(0);
+}
+
+CubePalette::~CubePalette()
+{
+    glDeleteBuffers(1, &m_vbo);
+    glDeleteVertexArrays(1, &m_vao);
+    glDeleteTextures(1, &m_textureArray);
 }
 
 const Cube &CubePalette::LookUp(Cube::Type type) const
 {
     return m_palette.at(type);
 }
+
+void CubePalette::Bind(ShaderProgram &shader) const
+{
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_textureArray);
+    shader.setUniform(ShaderProgram::Uniform::BlockLayers, m_layers.data(), static_cast<GLsizei>(m_layers.size()));
+}
+
+void CubePalette::DrawInstanced(GLuint instanceVbo, GLsizei count) const
+{
+    glBindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+    glVertexAttribIPointer(2, 4, GL_UNSIGNED_BYTE, 4 * sizeof(uint8_t), (void *)0);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 36, count);
+    glBindVertexArray(0);
+}
+
+GLuint CubePalette::createTextureArray(const std::vector<std::string> &texturePaths)
+{
+    std::vector<sf::Image> images(texturePaths.size());
+    std::vector<bool> usable(texturePaths.size(), false);
+    for (size_t i = 0; i < texturePaths.size(); ++i)
+    {
+        if (!images[i].loadFromFile(texturePaths[i]))
+        {
+            std::cerr << "Failed to load texture from: " << texturePaths[i] << ", using a placeholder" << std::endl;
+            continue;
+        }
+        images[i].flipVertically();
+        usable[i] = true;
+    }
+
+    // Warstwy tablicy muszą mieć ten sam rozmiar: pierwszej wczytanej tekstury
+    // albo zastępczy, gdy nie wczytała się żadna
+    const auto first = std::find(usable.begin(), usable.end(), true);
+    const size_t reference = static_cast<size_t>(first - usable.begin());
+    const sf::Vector2u size = first != usable.end() ? images[reference].getSize()
+                                                    : sf::Vector2u(s_placeholderSize, s_placeholderSize);
+    for (size_t i = 0; i < images.size(); ++i)
+    {
+        if (usable[i] && images[i].getSize() != size)
+        {
+            std::cerr << "Texture " << texturePaths[i] << " does not match the size of "
+                      << texturePaths[reference] << ", using a placeholder" << std::endl;
+            usable[i] = false;
+        }
+    }
+    const sf::Image placeholder = Placeholder(size);
+
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, size.x, size.y,
+                 static_cast<GLsizei>(images.size()), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    // Warstwa i zawsze pod indeksem i, więc typy wskazują wciąż na swoje tekstury
+    for (size_t i = 0; i < images.size(); ++i)
+    {
+        const sf::Image &image = usable[i] ? images[i] : placeholder;
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, static_cast<GLint>(i), size.x, size.y, 1,
+                        GL_RGBA, GL_UNSIGNED_BYTE, image.getPixelsPtr());
+    }
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    return texture;
+}
@@ -0,0 +1,154 @@
+#include "../include/Frustum.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FRUSTUM_X86 1
+#endif
+
+namespace {
+	// Corner of the box furthest along the plane normal: when even that one is
+	// behind the plane, the whole box is. The choice is the same for every box,
+	// so the batch kernels just pick the min or max array per axis.
+	struct PlaneCorner {
+		std::span<const float> m_x, m_y, m_z;
+	};
+
+	PlaneCorner Corner(const glm::vec4& plane, const AABB::Boxes& boxes) {
+		return { plane.x >= 0.0f ? boxes.m_maxX : boxes.m_minX,
+			plane.y >= 0.0f ? boxes.m_maxY : boxes.m_minY,
+			plane.z >= 0.0f ? boxes.m_maxZ : boxes.m_minZ };
+	}
+
+	// Kolejność działań jak w kernelach SIMD, żeby wyniki były te same
+	inline bool InFront(const glm::vec4& plane, float x, float y, float z) {
+		return plane.x * x + plane.y * y + plane.z * z + plane.w >= 0.0f;
+	}
+
+	size_t Scalar(const std::array<PlaneCorner, 6>& corners, const std::array<glm::vec4, 6>& planes, uint8_t* visible, size_t first, size_t count) {
+		size_t passed = 0;
+		for (size_t i = first; i < count; i++) {
+			size_t p = 0;
+			while (p < 6 && InFront(planes[p], corners[p].m_x[i], corners[p].m_y[i], corners[p].m_z[i])) {
+				p++;
+			}
+			visible[i] = p == 6 ? 1 : 0;
+			passed += visible[i];
+		}
+		return passed;
+	}
+
+#ifdef FRUSTUM_X86
+	__attribute__((target("sse4.1"))) size_t SSE(const std::array<PlaneCorner, 6>& corners, const std::array<glm::vec4, 6>& planes, uint8_t* visible, size_t count) {
+		size_t passed = 0;
+		for (size_t i = 0; i < count; i += 4) {
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (size_t p = 0; p < 6; p++) {
+				const PlaneCorner& c = corners[p];
+				__m128 distance = _mm_mul_ps(_mm_set1_ps(planes[p].x), _mm_loadu_ps(&c.m_x[i]));
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes[p].y), _mm_loadu_ps(&c.m_y[i])));
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes[p].z), _mm_loadu_ps(&c.m_z[i])));
+				distance = _mm_add_ps(distance, _mm_set1_ps(planes[p].w));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, _mm_setzero_ps()));
+			}
+			const int mask = _mm_movemask_ps(inside);
+			for (int k = 0; k < 4; k++) {
+				visible[i + k] = (mask >> k) & 1;
+			}
+			passed += __builtin_popcount(mask);
+		}
+		return passed;
+	}
+
+	__attribute__((target("avx"))) size_t AVX(const std::array<PlaneCorner, 6>& corners, const std::array<glm::vec4, 6>& planes, uint8_t* visible, size_t count) {
+		size_t passed = 0;
+		for (size_t i = 0; i < count; i += 8) {
+			__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (size_t p = 0; p < 6; p++) {
+				const PlaneCorner& c = corners[p];
+				__m256 distance = _mm256_mul_ps(_mm256_set1_ps(planes[p].x), _mm256_loadu_ps(&c.m_x[i]));
+				distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(planes[p].y), _mm256_loadu_ps(&c.m_y[i])));
+				distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(planes[p].z), _mm256_loadu_ps(&c.m_z[i])));
+				distance = _mm256_add_ps(distance, _mm256_set1_ps(planes[p].w));
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GE_OQ));
+			}
+			const int mask = _mm256_movemask_ps(inside);
+			for (int k = 0; k < 8; k++) {
+				visible[i + k] = (mask >> k) & 1;
+			}
+			passed += __builtin_popcount(mask);
+		}
+		return passed;
+	}
+#endif
+}
+
+Frustum::Frustum(const glm::mat4& viewProjection) {
+	// Wiersze macierzy (glm trzyma kolumny); płaszczyzny to w +- x, y, z w przestrzeni obcięcia
+	glm::vec4 rows[4];
+	for (int r = 0; r < 4; r++) {
+		rows[r] = glm::vec4(viewProjection[0][r], viewProjection[1][r], viewProjection[2][r], viewProjection[3][r]);
+	}
+
+	m_planes[static_cast<size_t>(Side::Left)] = rows[3] + rows[0];
+	m_planes[static_cast<size_t>(Side::Right)] = rows[3] - rows[0];
+	m_planes[static_cast<size_t>(Side::Bottom)] = rows[3] + rows[1];
+	m_planes[static_cast<size_t>(Side::Top)] = rows[3] - rows[1];
+	m_planes[static_cast<size_t>(Side::Near)] = rows[3] + rows[2];
+	m_planes[static_cast<size_t>(Side::Far)] = rows[3] - rows[2];
+
+	for (glm::vec4& plane : m_planes) {
+		plane = plane / glm::length(glm::vec3(plane));
+	}
+}
+
+float Frustum::Distance(Side side, const glm::vec3& point) const {
+	const glm::vec4& plane = Plane(side);
+	return plane.x * point.x + plane.y * point.y + plane.z * point.z + plane.w;
+}
+
+bool Frustum::Intersects(const AABB& box) const {
+	for (const glm::vec4& plane : m_planes) {
+		const glm::vec3 corner(plane.x >= 0.0f ? box.Max().x : box.Min().x,
+			plane.y >= 0.0f ? box.Max().y : box.Min().y,
+			plane.z >= 0.0f ? box.Max().z : box.Min().z);
+		if (!InFront(plane, corner.x, corner.y, corner.z)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+size_t Frustum::Intersects(const AABB::Boxes& boxes, std::span<uint8_t> visible) const {
+	return Intersects(boxes, visible, AABB::BestPath());
+}
+
+size_t Frustum::Intersects(const AABB::Boxes& boxes, std::span<uint8_t> visible, AABB::Path path) const {
+	// Jak w AABB: jeden bajt na pudełko, inaczej kernele piszą lub czytają poza tablicami
+	const size_t count = boxes.m_minX.size();
+	const std::initializer_list<std::span<const float>> spans{ boxes.m_minX, boxes.m_minY, boxes.m_minZ, boxes.m_maxX, boxes.m_maxY, boxes.m_maxZ };
+	if (visible.size() != count || !std::all_of(spans.begin(), spans.end(), [count](std::span<const float> span) { return span.size() == count; })) {
+		std::cerr << "Frustum: batch spans do not match " << count << " boxes" << std::endl;
+		return 0;
+	}
+
+	std::array<PlaneCorner, 6> corners;
+	for (size_t p = 0; p < 6; p++) {
+		corners[p] = Corner(m_planes[p], boxes);
+	}
+
+	size_t done = 0;
+	size_t passed = 0;
+#ifdef FRUSTUM_X86
+	if (path == AABB::Path::AVX) {
+		done = count & ~size_t(7);
+		passed = AVX(corners, m_planes, visible.data(), done);
+	} else if (path == AABB::Path::SSE41) {
+		done = count & ~size_t(3);
+		passed = SSE(corners, m_planes, visible.data(), done);
+	}
+#endif
+	return passed + Scalar(corners, m_planes, visible.data(), done, count);
+}
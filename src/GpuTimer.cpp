@@ -0,0 +1,58 @@
+#include "../include/GpuTimer.hpp"
+#include "../include/Profiler.hpp"
+
+GpuTimer::~GpuTimer()
+{
+  if (m_open.m_name)
+    glEndQuery(GL_TIME_ELAPSED);
+  for (const Query &query : m_pending)
+    m_free.push_back(query.m_id);
+  if (m_open.m_id != 0)
+    m_free.push_back(m_open.m_id);
+  if (!m_free.empty())
+    glDeleteQueries(static_cast<GLsizei>(m_free.size()), m_free.data());
+}
+
+void GpuTimer::Begin(const char *name)
+{
+  if (m_open.m_name || !Profiler::Enabled())
+    return;
+
+  if (m_free.empty())
+  {
+    GLuint id = 0;
+    glGenQueries(1, &id);
+    m_free.push_back(id);
+  }
+  m_open = {m_free.back(), name, Profiler::Now()};
+  m_free.pop_back();
+  glBeginQuery(GL_TIME_ELAPSED, m_open.m_id);
+}
+
+void GpuTimer::End()
+{
+  if (!m_open.m_name)
+    return;
+
+  glEndQuery(GL_TIME_ELAPSED);
+  m_pending.push_back(m_open);
+  m_open = {0, nullptr, 0};
+}
+
+void GpuTimer::Collect()
+{
+  while (!m_pending.empty())
+  {
+    const Query &query = m_pending.front();
+    GLint available = GL_FALSE;
+    glGetQueryObjectiv(query.m_id, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+      break;
+
+    GLuint64 elapsed = 0;
+    glGetQueryObjectui64v(query.m_id, GL_QUERY_RESULT, &elapsed);
+    Profiler::RecordGpu(query.m_name, query.m_start, elapsed);
+    m_free.push_back(query.m_id);
+    m_pending.pop_front();
+  }
+}
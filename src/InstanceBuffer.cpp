@@ -0,0 +1,67 @@
+#include "../include/InstanceBuffer.hpp"
+#include <utility>
+
+InstanceBuffer::InstanceBuffer(InstanceBuffer &&rhs) noexcept
+    : m_vbo(std::exchange(rhs.m_vbo, 0)), m_count(std::exchange(rhs.m_count, 0)) {}
+
+InstanceBuffer &InstanceBuffer::operator=(InstanceBuffer &&rhs) noexcept
+{
+  if (&rhs == this)
+  {
+    return *this;
+  }
+
+  Release();
+  m_vbo = std::exchange(rhs.m_vbo, 0);
+  m_count = std::exchange(rhs.m_count, 0);
+
+  return *this;
+}
+
+InstanceBuffer::~InstanceBuffer()
+{
+  Release();
+}
+
+void InstanceBuffer::Release()
+{
+  if (m_vbo != 0)
+    glDeleteBuffers(1, &m_vbo);
+  m_vbo = 0;
+  m_count = 0;
+}
+
+void InstanceBuffer::Upload(CubeInstances &instances)
+{
+  bool dirty = false;
+  for (size_t i = 1; i < Cube::s_typeCount; ++i)
+    dirty |= instances.IsDirty(static_cast<Cube::Type>(i));
+  if (!dirty)
+    return;
+
+  m_staging.clear();
+  for (size_t i = 1; i < Cube::s_typeCount; ++i)
+  {
+    const auto &offsets = instances.Instances(static_cast<Cube::Type>(i));
+    m_staging.insert(m_staging.end(), offsets.begin(), offsets.end());
+  }
+
+  if (m_vbo == 0)
+    glGenBuffers(1, &m_vbo);
+
+  glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+  glBufferData(GL_ARRAY_BUFFER, m_staging.size() * sizeof(CubeInstances::Offset),
+               m_staging.data(), GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  m_count = static_cast<GLsizei>(m_staging.size());
+  instances.ClearDirty();
+}
+
+void InstanceBuffer::Draw(const CubePalette &palette) const
+{
+  if (m_count == 0)
+    return;
+
+  palette.DrawInstanced(m_vbo, m_count);
+}
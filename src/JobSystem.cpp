@@ -0,0 +1,163 @@
+#include "../include/JobSystem.hpp"
+#include "../include/Profiler.hpp"
+#include <algorithm>
+
+namespace
+{
+  // Pool of the worker running on this thread and its index there; other
+  // pools treat the thread as an outsider
+  thread_local const JobSystem *t_owner = nullptr;
+  thread_local int t_workerIndex = -1;
+}
+
+JobSystem::JobSystem(size_t threadCount)
+{
+  for (size_t i = 0; i < threadCount; ++i)
+    m_workers.push_back(std::make_unique<Worker>());
+
+  for (size_t i = 0; i < threadCount; ++i)
+    m_threads.emplace_back(&JobSystem::Run, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+    m_stop = true;
+  }
+  m_wake.notify_all();
+
+  for (std::thread &thread : m_threads)
+    thread.join();
+}
+
+size_t JobSystem::DefaultThreadCount()
+{
+  const size_t hardware = std::thread::hardware_concurrency();
+  return hardware > 1 ? hardware - 1 : 1;
+}
+
+void JobSystem::Submit(Job job)
+{
+  if (m_workers.empty())
+  {
+    job();
+    return;
+  }
+
+  const size_t worker = t_owner == this ? static_cast<size_t>(t_workerIndex)
+                                        : m_next.fetch_add(1) % m_workers.size();
+  {
+    std::lock_guard<std::mutex> lock(m_workers[worker]->m_mutex);
+    m_workers[worker]->m_jobs.push_back(std::move(job));
+  }
+  {
+    // Pod blokadą, żeby wątek zasypiający nie przegapił powiadomienia
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+    m_queued.fetch_add(1);
+  }
+  m_wake.notify_one();
+}
+
+void JobSystem::ParallelFor(size_t count, const std::function<void(size_t)> &body)
+{
+  if (count == 0)
+    return;
+
+  if (m_workers.empty() || count == 1)
+  {
+    for (size_t i = 0; i < count; ++i)
+      body(i);
+    return;
+  }
+
+  // Kilka partii na wątek, żeby szybsi mogli wyrównać nierówne koszty.
+  // Partie bierze ten, kto pierwszy sięgnie po następną: pomocnicy z puli
+  // i sam wołający, który dzięki temu nie wykonuje cudzych zadań
+  struct Batches
+  {
+    const std::function<void(size_t)> *m_body;
+    size_t m_count;
+    size_t m_batches;
+    std::atomic<size_t> m_next{0};
+    std::atomic<size_t> m_remaining;
+  };
+  const size_t batches = std::min(count, (m_workers.size() + 1) * 4);
+  auto state = std::make_shared<Batches>(&body, count, batches, 0, batches);
+  // Pomocnik, który przyjdzie po wszystkim, nie dotyka już body
+  const auto work = [](Batches &state)
+  {
+    for (size_t b = state.m_next.fetch_add(1); b < state.m_batches; b = state.m_next.fetch_add(1))
+    {
+      const size_t last = state.m_count * (b + 1) / state.m_batches;
+      for (size_t i = state.m_count * b / state.m_batches; i < last; ++i)
+        (*state.m_body)(i);
+      state.m_remaining.fetch_sub(1, std::memory_order_release);
+    }
+  };
+  const size_t helpers = std::min(m_workers.size(), batches - 1);
+  for (size_t h = 0; h < helpers; ++h)
+    Submit([state, work]
+           { work(*state); });
+
+  work(*state);
+  while (state->m_remaining.load(std::memory_order_acquire) != 0)
+    std::this_thread::yield();
+}
+
+bool JobSystem::TryRun(size_t worker)
+{
+  Job job;
+  if (!Pop(worker, job))
+    return false;
+
+  m_queued.fetch_sub(1);
+  job();
+  return true;
+}
+
+bool JobSystem::Pop(size_t worker, Job &job)
+{
+  {
+    Worker &own = *m_workers[worker];
+    std::lock_guard<std::mutex> lock(own.m_mutex);
+    if (!own.m_jobs.empty())
+    {
+      job = std::move(own.m_jobs.back());
+      own.m_jobs.pop_back();
+      return true;
+    }
+  }
+
+  for (size_t i = 1; i < m_workers.size(); ++i)
+  {
+    Worker &victim = *m_workers[(worker + i) % m_workers.size()];
+    std::lock_guard<std::mutex> lock(victim.m_mutex);
+    if (!victim.m_jobs.empty())
+    {
+      job = std::move(victim.m_jobs.front());
+      victim.m_jobs.pop_front();
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void JobSystem::Run(size_t worker)
+{
+  t_owner = this;
+  t_workerIndex = static_cast<int>(worker);
+  Profiler::SetThreadName("Worker " + std::to_string(worker));
+  while (true)
+  {
+    if (TryRun(worker))
+      continue;
+
+    std::unique_lock<std::mutex> lock(m_wakeMutex);
+    m_wake.wait(lock, [this]
+                { return m_stop || m_queued.load() != 0; });
+    if (m_stop)
+      return;
+  }
+}
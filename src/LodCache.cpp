@@ -0,0 +1,88 @@
+#include "../include/LodCache.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+LodCache::LodCache(int levels, size_t budget)
+	: m_levels(levels)
+	, m_budget(budget) {
+}
+
+const MeshBuffer* LodCache::Find(const Key& key, uint32_t revision) {
+	const auto found = m_index.find(key);
+	if (found == m_index.end()) {
+		return nullptr;
+	}
+	const List_t::iterator entry = found->second;
+	if (entry->m_revision != revision) {
+		Remove(entry); // Chunk edited since
+		return nullptr;
+	}
+	if (entry->m_frame != m_frame) {
+		entry->m_frame = m_frame;
+		m_pinned += entry->m_bytes;
+	}
+	m_entries.splice(m_entries.begin(), m_entries, entry);
+	return &entry->m_buffer;
+}
+
+bool LodCache::Refused(const Key& key, uint32_t revision) {
+	const auto found = m_refused.find(key);
+	if (found == m_refused.end()) {
+		return false;
+	}
+	if (found->second.m_revision != revision) {
+		m_refused.erase(found); // Inna siatka, może się zmieści
+		return false;
+	}
+	// Budżet mógł urosnąć albo mniej siatek jest przypiętych w tej klatce
+	return found->second.m_bytes > m_budget - std::min(m_pinned, m_budget);
+}
+
+const MeshBuffer* LodCache::Insert(const Key& key, uint32_t revision, const ChunkMesh& mesh) {
+	const auto found = m_index.find(key);
+	if (found != m_index.end()) {
+		Remove(found->second);
+	}
+
+	const size_t bytes = mesh.m_vertices.size() * sizeof(MeshVertex) + mesh.m_indices.size() * sizeof(uint32_t);
+	// Siatek z bieżącej klatki nie wolno usunąć; bez miejsca obok nich nic
+	// nie jest usuwane na próżno
+	if (bytes > m_budget - std::min(m_pinned, m_budget)) {
+		m_refused[key] = Refusal{ revision, bytes };
+		return nullptr;
+	}
+	m_refused.erase(key);
+
+	// Od najdawniej rysowanych, ale nie te z bieżącej klatki
+	while (m_used + bytes > m_budget && !m_entries.empty() && m_entries.back().m_frame != m_frame) {
+		Remove(std::prev(m_entries.end()));
+	}
+
+	m_entries.push_front(Entry{ key, revision, bytes, m_frame, MeshBuffer() });
+	m_entries.front().m_buffer.Upload(mesh);
+	m_index[key] = m_entries.begin();
+	m_used += bytes;
+	m_pinned += bytes;
+	return &m_entries.front().m_buffer;
+}
+
+void LodCache::Erase(const glm::ivec2& coords) {
+	for (int level = 0; level < m_levels; level++) {
+		const Key key{ coords, level };
+		const auto found = m_index.find(key);
+		if (found != m_index.end()) {
+			Remove(found->second);
+		}
+		m_refused.erase(key);
+	}
+}
+
+void LodCache::Remove(List_t::iterator entry) {
+	m_used -= entry->m_bytes;
+	if (entry->m_frame == m_frame) {
+		m_pinned -= entry->m_bytes;
+	}
+	m_index.erase(entry->m_key);
+	m_entries.erase(entry);
+}
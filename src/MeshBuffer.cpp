@@ -0,0 +1,91 @@
+#include "../include/MeshBuffer.hpp"
+#include <cstddef>
+#include <utility>
+
+MeshBuffer::MeshBuffer(MeshBuffer &&rhs) noexcept
+    : m_vao(std::exchange(rhs.m_vao, 0)), m_vbo(std::exchange(rhs.m_vbo, 0)),
+      m_ebo(std::exchange(rhs.m_ebo, 0)), m_indexCount(std::exchange(rhs.m_indexCount, 0)) {}
+
+MeshBuffer &MeshBuffer::operator=(MeshBuffer &&rhs) noexcept
+{
+  if (&rhs == this)
+  {
+    return *this;
+  }
+
+  Release();
+  m_vao = std::exchange(rhs.m_vao, 0);
+  m_vbo = std::exchange(rhs.m_vbo, 0);
+  m_ebo = std::exchange(rhs.m_ebo, 0);
+  m_indexCount = std::exchange(rhs.m_indexCount, 0);
+
+  return *this;
+}
+
+MeshBuffer::~MeshBuffer()
+{
+  Release();
+}
+
+void MeshBuffer::Release()
+{
+  if (m_vao == 0)
+    return;
+
+  glDeleteBuffers(1, &m_vbo);
+  glDeleteBuffers(1, &m_ebo);
+  glDeleteVertexArrays(1, &m_vao);
+  m_vao = m_vbo = m_ebo = 0;
+}
+
+void MeshBuffer::Upload(const ChunkMesh &mesh)
+{
+  // Chunk bez widocznych ścian, np. samo powietrze, nie potrzebuje obiektów GL
+  if (m_vao == 0 && mesh.m_indices.empty())
+  {
+    m_indexCount = 0;
+    return;
+  }
+
+  if (m_vao == 0)
+  {
+    glGenVertexArrays(1, &m_vao);
+    glGenBuffers(1, &m_vbo);
+    glGenBuffers(1, &m_ebo);
+
+    glBindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+
+    glVertexAttribIPointer(0, 4, GL_UNSIGNED_BYTE, sizeof(MeshVertex),
+                           (void *)offsetof(MeshVertex, m_x)); // Pozycja + sciana
+    glEnableVertexAttribArray(0);
+
+    glVertexAttribIPointer(1, 4, GL_UNSIGNED_BYTE, sizeof(MeshVertex),
+                           (void *)offsetof(MeshVertex, m_u)); // Pozycja w scianie + typ
+    glEnableVertexAttribArray(1);
+  }
+  else
+  {
+    glBindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+  }
+
+  glBufferData(GL_ARRAY_BUFFER, mesh.m_vertices.size() * sizeof(MeshVertex),
+               mesh.m_vertices.data(), GL_STATIC_DRAW);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.m_indices.size() * sizeof(uint32_t),
+               mesh.m_indices.data(), GL_STATIC_DRAW);
+
+  glBindVertexArray(0);
+  m_indexCount = static_cast<GLsizei>(mesh.m_indices.size());
+}
+
+void MeshBuffer::Draw() const
+{
+  if (m_indexCount == 0)
+    return;
+
+  glBindVertexArray(m_vao);
+  glDrawElements(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, (void *)0);
+  glBindVertexArray(0);
+}
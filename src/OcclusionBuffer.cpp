@@ -0,0 +1,233 @@
+#include "../include/OcclusionBuffer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define OCCLUSION_X86 1
+#endif
+
+namespace {
+	// a * x + b * y + c at a pixel centre; edge functions and depth are all of this form
+	struct Linear {
+		float m_a, m_b, m_c;
+
+		float At(float x, float y) const { return m_a * x + m_b * y + m_c; }
+	};
+
+	// One box face: a convex quad on screen
+	struct Quad {
+		std::array<Linear, 4> m_edges; // >= 0 inside
+		Linear m_depth;
+		int m_minX, m_maxX, m_minY, m_maxY;
+	};
+
+	// Positive on the left of u -> v, so inside a counter-clockwise polygon
+	Linear Edge(float ux, float uy, float vx, float vy) {
+		return { -(vy - uy), vx - ux, (vy - uy) * ux - (vx - ux) * uy };
+	}
+
+	void ScalarRows(const Quad& t, float* depth, int width) {
+		for (int y = t.m_minY; y <= t.m_maxY; y++) {
+			float* row = depth + static_cast<size_t>(y) * width;
+			const float py = y + 0.5f;
+			for (int x = t.m_minX; x <= t.m_maxX; x++) {
+				const float px = x + 0.5f;
+				if (t.m_edges[0].At(px, py) >= 0.0f && t.m_edges[1].At(px, py) >= 0.0f && t.m_edges[2].At(px, py) >= 0.0f && t.m_edges[3].At(px, py) >= 0.0f) {
+					row[x] = std::max(row[x], t.m_depth.At(px, py));
+				}
+			}
+		}
+	}
+
+	bool ScalarVisible(const float* depth, int width, int minX, int maxX, int minY, int maxY, float nearest) {
+		for (int y = minY; y <= maxY; y++) {
+			const float* row = depth + static_cast<size_t>(y) * width;
+			for (int x = minX; x <= maxX; x++) {
+				if (row[x] < nearest) {
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+#ifdef OCCLUSION_X86
+	__attribute__((target("avx"))) inline __m256 At(const Linear& l, __m256 px, __m256 py) {
+		return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(l.m_a), px), _mm256_mul_ps(_mm256_set1_ps(l.m_b), py)), _mm256_set1_ps(l.m_c));
+	}
+
+	// Whole groups of 8 pixels from an aligned start; lanes outside the quad
+	// fail the edge tests, so the bounding box needs no lane mask
+	__attribute__((target("avx"))) void AVXRows(const Quad& t, float* depth, int width) {
+		const __m256 offsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+		const __m256 zero = _mm256_setzero_ps();
+		const int firstX = t.m_minX & ~7;
+		for (int y = t.m_minY; y <= t.m_maxY; y++) {
+			float* row = depth + static_cast<size_t>(y) * width;
+			const __m256 py = _mm256_set1_ps(y + 0.5f);
+			for (int x = firstX; x <= t.m_maxX; x += 8) {
+				const __m256 px = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), offsets);
+				__m256 inside = _mm256_cmp_ps(At(t.m_edges[0], px, py), zero, _CMP_GE_OQ);
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(At(t.m_edges[1], px, py), zero, _CMP_GE_OQ));
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(At(t.m_edges[2], px, py), zero, _CMP_GE_OQ));
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(At(t.m_edges[3], px, py), zero, _CMP_GE_OQ));
+				// Poza ścianą 0, a bufor nigdy nie jest ujemny, więc max nic tam nie zmienia
+				const __m256 z = _mm256_and_ps(inside, At(t.m_depth, px, py));
+				_mm256_storeu_ps(row + x, _mm256_max_ps(_mm256_loadu_ps(row + x), z));
+			}
+		}
+	}
+
+	__attribute__((target("avx"))) bool AVXVisible(const float* depth, int width, int minX, int maxX, int minY, int maxY, float nearest) {
+		const __m256 target = _mm256_set1_ps(nearest);
+		for (int y = minY; y <= maxY; y++) {
+			const float* row = depth + static_cast<size_t>(y) * width;
+			int x = minX;
+			for (; x + 8 <= maxX + 1; x += 8) {
+				if (_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(row + x), target, _CMP_LT_OQ))) {
+					return true;
+				}
+			}
+			for (; x <= maxX; x++) {
+				if (row[x] < nearest) {
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+#endif
+
+	// Corners: bit 0 = max x, bit 1 = max y, bit 2 = max z. Counter-clockwise
+	// seen from outside, so faces turned away come out clockwise on screen.
+	constexpr std::array<std::array<int, 4>, 6> s_faces = { {
+		{ 0, 4, 6, 2 }, { 1, 3, 7, 5 },
+		{ 0, 1, 5, 4 }, { 2, 6, 7, 3 },
+		{ 0, 2, 3, 1 }, { 4, 5, 7, 6 },
+	} };
+}
+
+OcclusionBuffer::OcclusionBuffer(int width, int height)
+	: m_width((width + 7) & ~7)
+	, m_height(height)
+	, m_depth(static_cast<size_t>(m_width) * height, 0.0f)
+	, m_path(AABB::BestPath()) {
+}
+
+void OcclusionBuffer::Clear(const glm::mat4& viewProjection) {
+	m_viewProjection = viewProjection;
+	std::fill(m_depth.begin(), m_depth.end(), 0.0f);
+}
+
+bool OcclusionBuffer::Project(const AABB& box, std::array<Vertex, 8>& corners) const {
+	// Obraz rogu to obraz min plus kolumny macierzy przeskalowane o rozmiar pudełka
+	const glm::vec3 size = box.Max() - box.Min();
+	const glm::vec4 base = m_viewProjection * glm::vec4(box.Min(), 1.0f);
+	const glm::vec4 axes[3] = { m_viewProjection[0] * size.x, m_viewProjection[1] * size.y, m_viewProjection[2] * size.z };
+	for (int i = 0; i < 8; i++) {
+		glm::vec4 clip = base;
+		for (int axis = 0; axis < 3; axis++) {
+			if (i & (1 << axis)) {
+				clip += axes[axis];
+			}
+		}
+		// Przed płaszczyzną bliską w przestrzeni obcięcia GL: z > -w
+		if (!(clip.z > -clip.w) || clip.w <= 0.0f) {
+			return false;
+		}
+		const float inverse = 1.0f / clip.w;
+		corners[i] = { (clip.x * inverse * 0.5f + 0.5f) * m_width, (clip.y * inverse * 0.5f + 0.5f) * m_height, inverse };
+	}
+	return true;
+}
+
+void OcclusionBuffer::DrawOccluder(const AABB& box) {
+	std::array<Vertex, 8> corners;
+	if (!Project(box, corners) || !IsVisible(corners)) {
+		return;
+	}
+	for (const auto& face : s_faces) {
+		DrawFace({ corners[face[0]], corners[face[1]], corners[face[2]], corners[face[3]] });
+	}
+}
+
+void OcclusionBuffer::DrawFace(const std::array<Vertex, 4>& v) {
+	const Vertex& a = v[0];
+	const Vertex& b = v[1];
+	const Vertex& c = v[2];
+	// Twice the area of abc; the face is a parallelogram only before projection, so abc alone gives the winding
+	const float area = (b.m_x - a.m_x) * (c.m_y - a.m_y) - (b.m_y - a.m_y) * (c.m_x - a.m_x);
+	if (!(area > 0.0f)) {
+		return; // Turned away from the camera or edge-on
+	}
+
+	Quad q;
+	q.m_minX = std::max(0, static_cast<int>(std::floor(std::min({ v[0].m_x, v[1].m_x, v[2].m_x, v[3].m_x }))));
+	q.m_maxX = std::min(m_width - 1, static_cast<int>(std::ceil(std::max({ v[0].m_x, v[1].m_x, v[2].m_x, v[3].m_x }))));
+	q.m_minY = std::max(0, static_cast<int>(std::floor(std::min({ v[0].m_y, v[1].m_y, v[2].m_y, v[3].m_y }))));
+	q.m_maxY = std::min(m_height - 1, static_cast<int>(std::ceil(std::max({ v[0].m_y, v[1].m_y, v[2].m_y, v[3].m_y }))));
+	if (q.m_minX > q.m_maxX || q.m_minY > q.m_maxY) {
+		return;
+	}
+
+	for (int i = 0; i < 4; i++) {
+		const Vertex& u = v[i];
+		const Vertex& w = v[(i + 1) & 3];
+		q.m_edges[i] = Edge(u.m_x, u.m_y, w.m_x, w.m_y);
+	}
+	// 1 / w jest liniowe na ekranie w płaszczyźnie ściany; wagi barycentryczne abc, krawędź naprzeciw wierzchołka
+	const Linear opposite[3] = { q.m_edges[1], Edge(c.m_x, c.m_y, a.m_x, a.m_y), q.m_edges[0] };
+	const float inverseArea = 1.0f / area;
+	const float weights[3] = { a.m_z * inverseArea, b.m_z * inverseArea, c.m_z * inverseArea };
+	q.m_depth = { 0.0f, 0.0f, 0.0f };
+	for (int i = 0; i < 3; i++) {
+		q.m_depth.m_a += opposite[i].m_a * weights[i];
+		q.m_depth.m_b += opposite[i].m_b * weights[i];
+		q.m_depth.m_c += opposite[i].m_c * weights[i];
+	}
+
+#ifdef OCCLUSION_X86
+	if (m_path == AABB::Path::AVX) {
+		AVXRows(q, m_depth.data(), m_width);
+		return;
+	}
+#endif
+	ScalarRows(q, m_depth.data(), m_width);
+}
+
+bool OcclusionBuffer::IsVisible(const AABB& box) const {
+	std::array<Vertex, 8> corners;
+	if (!Project(box, corners)) {
+		return true; // Reaches the camera
+	}
+	return IsVisible(corners);
+}
+
+bool OcclusionBuffer::IsVisible(const std::array<Vertex, 8>& corners) const {
+	float minX = corners[0].m_x, maxX = minX, minY = corners[0].m_y, maxY = minY, nearest = corners[0].m_z;
+	for (const Vertex& v : corners) {
+		minX = std::min(minX, v.m_x);
+		maxX = std::max(maxX, v.m_x);
+		minY = std::min(minY, v.m_y);
+		maxY = std::max(maxY, v.m_y);
+		nearest = std::max(nearest, v.m_z);
+	}
+
+	// Every pixel the rectangle touches; none at all when it is off screen
+	const int x0 = std::max(0, static_cast<int>(std::floor(minX)));
+	const int x1 = std::min(m_width - 1, static_cast<int>(std::ceil(maxX)) - 1);
+	const int y0 = std::max(0, static_cast<int>(std::floor(minY)));
+	const int y1 = std::min(m_height - 1, static_cast<int>(std::ceil(maxY)) - 1);
+	if (x0 > x1 || y0 > y1) {
+		return false;
+	}
+
+#ifdef OCCLUSION_X86
+	if (m_path == AABB::Path::AVX) {
+		return AVXVisible(m_depth.data(), m_width, x0, x1, y0, y1, nearest);
+	}
+#endif
+	return ScalarVisible(m_depth.data(), m_width, x0, x1, y0, y1, nearest);
+}
@@ -1,7 +1,12 @@
 #include "../include/PerlinNoise.hpp"
+#include "../include/Random.hpp"
 #include <algorithm>
 #include <cmath>
-#include <random>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PERLIN_NOISE_X86 1
+#endif
 
 namespace {
 	constexpr std::array<uint8_t, 256> s_permutations = {
@@ -30,18 +35,251 @@ namespace {
 
 		return ((h & 1) == 0 ? u : -u) + ((h & 2) == 0 ? v : -v);
 	}
+
+#ifdef PERLIN_NOISE_X86
+	// Kernele SIMD powtarzają dokładnie operacje At: Fade liczy wielomian
+	// w double jak wersja skalarna, Lerp odtwarza gałęzie std::lerp z libstdc++
+
+	__attribute__((target("sse4.1"))) inline __m128 FadeSSE(__m128 t) {
+		const __m128 t3 = _mm_mul_ps(_mm_mul_ps(t, t), t);
+		const __m128d tLo = _mm_cvtps_pd(t);
+		const __m128d tHi = _mm_cvtps_pd(_mm_movehl_ps(t, t));
+		const __m128d pLo = _mm_add_pd(_mm_mul_pd(tLo, _mm_sub_pd(_mm_mul_pd(tLo, _mm_set1_pd(6.0)), _mm_set1_pd(15.0))), _mm_set1_pd(10.0));
+		const __m128d pHi = _mm_add_pd(_mm_mul_pd(tHi, _mm_sub_pd(_mm_mul_pd(tHi, _mm_set1_pd(6.0)), _mm_set1_pd(15.0))), _mm_set1_pd(10.0));
+		const __m128 lo = _mm_cvtpd_ps(_mm_mul_pd(_mm_cvtps_pd(t3), pLo));
+		const __m128 hi = _mm_cvtpd_ps(_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(t3, t3)), pHi));
+		return _mm_movelh_ps(lo, hi);
+	}
+
+	__attribute__((target("sse4.1"))) inline __m128 GradSSE(__m128i hash, __m128 x, __m128 y, __m128 z) {
+		const __m128i h = _mm_and_si128(hash, _mm_set1_epi32(15));
+		const __m128 below8 = _mm_castsi128_ps(_mm_cmplt_epi32(h, _mm_set1_epi32(8)));
+		const __m128 below4 = _mm_castsi128_ps(_mm_cmplt_epi32(h, _mm_set1_epi32(4)));
+		const __m128 is12or14 = _mm_castsi128_ps(_mm_or_si128(_mm_cmpeq_epi32(h, _mm_set1_epi32(12)), _mm_cmpeq_epi32(h, _mm_set1_epi32(14))));
+
+		const __m128 u = _mm_blendv_ps(y, x, below8);
+		const __m128 v = _mm_blendv_ps(_mm_blendv_ps(z, x, is12or14), y, below4);
+		// Bity 0 i 1 hasha przenoszone na bit znaku
+		const __m128 uSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(1)), 31));
+		const __m128 vSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(2)), 30));
+		return _mm_add_ps(_mm_xor_ps(u, uSign), _mm_xor_ps(v, vSign));
+	}
+
+	__attribute__((target("sse4.1"))) inline __m128 LerpSSE(__m128 a, __m128 b, __m128 t) {
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 straddles = _mm_or_ps(_mm_and_ps(_mm_cmple_ps(a, zero), _mm_cmpge_ps(b, zero)),
+										   _mm_and_ps(_mm_cmpge_ps(a, zero), _mm_cmple_ps(b, zero)));
+		const __m128 exact = _mm_add_ps(_mm_mul_ps(t, b), _mm_mul_ps(_mm_sub_ps(one, t), a));
+
+		const __m128 x = _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));
+		const __m128 rising = _mm_blendv_ps(b, x, _mm_cmplt_ps(b, x));
+		const __m128 falling = _mm_blendv_ps(b, x, _mm_cmpgt_ps(b, x));
+		const __m128 differ = _mm_xor_ps(_mm_cmpgt_ps(t, one), _mm_cmpgt_ps(b, a));
+		__m128 result = _mm_blendv_ps(rising, falling, differ);
+		result = _mm_blendv_ps(result, b, _mm_cmpeq_ps(t, one));
+		return _mm_blendv_ps(result, exact, straddles);
+	}
+
+	__attribute__((target("sse4.1"))) inline __m128i LookUpSSE(const int32_t *table, __m128i index) {
+		return _mm_setr_epi32(table[_mm_extract_epi32(index, 0)], table[_mm_extract_epi32(index, 1)],
+							  table[_mm_extract_epi32(index, 2)], table[_mm_extract_epi32(index, 3)]);
+	}
+
+	__attribute__((target("sse4.1"))) void AtBatchSSE(const int32_t *perm, const float *xs, const float *ys, const float *zs, float *out, size_t count) {
+		const __m128i mask = _mm_set1_epi32(255);
+		const __m128i one = _mm_set1_epi32(1);
+		const __m128 oneF = _mm_set1_ps(1.0f);
+
+		for (size_t i = 0; i + 4 <= count; i += 4) {
+			const __m128 x = _mm_loadu_ps(xs + i);
+			const __m128 y = _mm_loadu_ps(ys + i);
+			const __m128 z = _mm_loadu_ps(zs + i);
+			const __m128 _x = _mm_floor_ps(x);
+			const __m128 _y = _mm_floor_ps(y);
+			const __m128 _z = _mm_floor_ps(z);
+
+			const __m128i ix = _mm_and_si128(_mm_cvttps_epi32(_x), mask);
+			const __m128i iy = _mm_and_si128(_mm_cvttps_epi32(_y), mask);
+			const __m128i iz = _mm_and_si128(_mm_cvttps_epi32(_z), mask);
+
+			const __m128 fx = _mm_sub_ps(x, _x);
+			const __m128 fy = _mm_sub_ps(y, _y);
+			const __m128 fz = _mm_sub_ps(z, _z);
+			const __m128 fx1 = _mm_sub_ps(fx, oneF);
+			const __m128 fy1 = _mm_sub_ps(fy, oneF);
+			const __m128 fz1 = _mm_sub_ps(fz, oneF);
+
+			const __m128 u = FadeSSE(fx);
+			const __m128 v = FadeSSE(fy);
+			const __m128 w = FadeSSE(fz);
+
+			const __m128i A = _mm_and_si128(_mm_add_epi32(LookUpSSE(perm, ix), iy), mask);
+			const __m128i B = _mm_and_si128(_mm_add_epi32(LookUpSSE(perm, _mm_and_si128(_mm_add_epi32(ix, one), mask)), iy), mask);
+			const __m128i AA = _mm_and_si128(_mm_add_epi32(LookUpSSE(perm, A), iz), mask);
+			const __m128i AB = _mm_and_si128(_mm_add_epi32(LookUpSSE(perm, _mm_and_si128(_mm_add_epi32(A, one), mask)), iz), mask);
+			const __m128i BA = _mm_and_si128(_mm_add_epi32(LookUpSSE(perm, B), iz), mask);
+			const __m128i BB = _mm_and_si128(_mm_add_epi32(LookUpSSE(perm, _mm_and_si128(_mm_add_epi32(B, one), mask)), iz), mask);
+
+			const __m128 p0 = GradSSE(LookUpSSE(perm, AA), fx, fy, fz);
+			const __m128 p1 = GradSSE(LookUpSSE(perm, BA), fx1, fy, fz);
+			const __m128 p2 = GradSSE(LookUpSSE(perm, AB), fx, fy1, fz);
+			const __m128 p3 = GradSSE(LookUpSSE(perm, BB), fx1, fy1, fz);
+			const __m128 p4 = GradSSE(LookUpSSE(perm, _mm_and_si128(_mm_add_epi32(AA, one), mask)), fx, fy, fz1);
+			const __m128 p5 = GradSSE(LookUpSSE(perm, _mm_and_si128(_mm_add_epi32(BA, one), mask)), fx1, fy, fz1);
+			const __m128 p6 = GradSSE(LookUpSSE(perm, _mm_and_si128(_mm_add_epi32(AB, one), mask)), fx, fy1, fz1);
+			const __m128 p7 = GradSSE(LookUpSSE(perm, _mm_and_si128(_mm_add_epi32(BB, one), mask)), fx1, fy1, fz1);
+
+			const __m128 r0 = LerpSSE(LerpSSE(p0, p1, u), LerpSSE(p2, p3, u), v);
+			const __m128 r1 = LerpSSE(LerpSSE(p4, p5, u), LerpSSE(p6, p7, u), v);
+			const __m128 result = LerpSSE(r0, r1, w);
+			_mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(result, _mm_set1_ps(0.5f)), _mm_set1_ps(0.5f)));
+		}
+	}
+
+	__attribute__((target("avx2"))) inline __m256 FadeAVX2(__m256 t) {
+		const __m256 t3 = _mm256_mul_ps(_mm256_mul_ps(t, t), t);
+		const __m256d tLo = _mm256_cvtps_pd(_mm256_castps256_ps128(t));
+		const __m256d tHi = _mm256_cvtps_pd(_mm256_extractf128_ps(t, 1));
+		const __m256d pLo = _mm256_add_pd(_mm256_mul_pd(tLo, _mm256_sub_pd(_mm256_mul_pd(tLo, _mm256_set1_pd(6.0)), _mm256_set1_pd(15.0))), _mm256_set1_pd(10.0));
+		const __m256d pHi = _mm256_add_pd(_mm256_mul_pd(tHi, _mm256_sub_pd(_mm256_mul_pd(tHi, _mm256_set1_pd(6.0)), _mm256_set1_pd(15.0))), _mm256_set1_pd(10.0));
+		const __m128 lo = _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(t3)), pLo));
+		const __m128 hi = _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(t3, 1)), pHi));
+		return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+	}
+
+	__attribute__((target("avx2"))) inline __m256 GradAVX2(__m256i hash, __m256 x, __m256 y, __m256 z) {
+		const __m256i h = _mm256_and_si256(hash, _mm256_set1_epi32(15));
+		const __m256 below8 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(8), h));
+		const __m256 below4 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(4), h));
+		const __m256 is12or14 = _mm256_castsi256_ps(_mm256_or_si256(_mm256_cmpeq_epi32(h, _mm256_set1_epi32(12)), _mm256_cmpeq_epi32(h, _mm256_set1_epi32(14))));
+
+		const __m256 u = _mm256_blendv_ps(y, x, below8);
+		const __m256 v = _mm256_blendv_ps(_mm256_blendv_ps(z, x, is12or14), y, below4);
+		const __m256 uSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(1)), 31));
+		const __m256 vSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(2)), 30));
+		return _mm256_add_ps(_mm256_xor_ps(u, uSign), _mm256_xor_ps(v, vSign));
+	}
+
+	__attribute__((target("avx2"))) inline __m256 LerpAVX2(__m256 a, __m256 b, __m256 t) {
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 straddles = _mm256_or_ps(_mm256_and_ps(_mm256_cmp_ps(a, zero, _CMP_LE_OQ), _mm256_cmp_ps(b, zero, _CMP_GE_OQ)),
+											  _mm256_and_ps(_mm256_cmp_ps(a, zero, _CMP_GE_OQ), _mm256_cmp_ps(b, zero, _CMP_LE_OQ)));
+		const __m256 exact = _mm256_add_ps(_mm256_mul_ps(t, b), _mm256_mul_ps(_mm256_sub_ps(one, t), a));
+
+		const __m256 x = _mm256_add_ps(a, _mm256_mul_ps(t, _mm256_sub_ps(b, a)));
+		const __m256 rising = _mm256_blendv_ps(b, x, _mm256_cmp_ps(b, x, _CMP_LT_OQ));
+		const __m256 falling = _mm256_blendv_ps(b, x, _mm256_cmp_ps(b, x, _CMP_GT_OQ));
+		const __m256 differ = _mm256_xor_ps(_mm256_cmp_ps(t, one, _CMP_GT_OQ), _mm256_cmp_ps(b, a, _CMP_GT_OQ));
+		__m256 result = _mm256_blendv_ps(rising, falling, differ);
+		result = _mm256_blendv_ps(result, b, _mm256_cmp_ps(t, one, _CMP_EQ_OQ));
+		return _mm256_blendv_ps(result, exact, straddles);
+	}
+
+	__attribute__((target("avx2"))) inline __m256i LookUpAVX2(const int32_t *table, __m256i index) {
+		return _mm256_i32gather_epi32(table, index, 4);
+	}
+
+	__attribute__((target("avx2"))) void AtBatchAVX2(const int32_t *perm, const float *xs, const float *ys, const float *zs, float *out, size_t count) {
+		const __m256i mask = _mm256_set1_epi32(255);
+		const __m256i one = _mm256_set1_epi32(1);
+		const __m256 oneF = _mm256_set1_ps(1.0f);
+
+		for (size_t i = 0; i + 8 <= count; i += 8) {
+			const __m256 x = _mm256_loadu_ps(xs + i);
+			const __m256 y = _mm256_loadu_ps(ys + i);
+			const __m256 z = _mm256_loadu_ps(zs + i);
+			const __m256 _x = _mm256_floor_ps(x);
+			const __m256 _y = _mm256_floor_ps(y);
+			const __m256 _z = _mm256_floor_ps(z);
+
+			const __m256i ix = _mm256_and_si256(_mm256_cvttps_epi32(_x), mask);
+			const __m256i iy = _mm256_and_si256(_mm256_cvttps_epi32(_y), mask);
+			const __m256i iz = _mm256_and_si256(_mm256_cvttps_epi32(_z), mask);
+
+			const __m256 fx = _mm256_sub_ps(x, _x);
+			const __m256 fy = _mm256_sub_ps(y, _y);
+			const __m256 fz = _mm256_sub_ps(z, _z);
+			const __m256 fx1 = _mm256_sub_ps(fx, oneF);
+			const __m256 fy1 = _mm256_sub_ps(fy, oneF);
+			const __m256 fz1 = _mm256_sub_ps(fz, oneF);
+
+			const __m256 u = FadeAVX2(fx);
+			const __m256 v = FadeAVX2(fy);
+			const __m256 w = FadeAVX2(fz);
+
+			const __m256i A = _mm256_and_si256(_mm256_add_epi32(LookUpAVX2(perm, ix), iy), mask);
+			const __m256i B = _mm256_and_si256(_mm256_add_epi32(LookUpAVX2(perm, _mm256_and_si256(_mm256_add_epi32(ix, one), mask)), iy), mask);
+			const __m256i AA = _mm256_and_si256(_mm256_add_epi32(LookUpAVX2(perm, A), iz), mask);
+			const __m256i AB = _mm256_and_si256(_mm256_add_epi32(LookUpAVX2(perm, _mm256_and_si256(_mm256_add_epi32(A, one), mask)), iz), mask);
+			const __m256i BA = _mm256_and_si256(_mm256_add_epi32(LookUpAVX2(perm, B), iz), mask);
+			const __m256i BB = _mm256_and_si256(_mm256_add_epi32(LookUpAVX2(perm, _mm256_and_si256(_mm256_add_epi32(B, one), mask)), iz), mask);
+
+			const __m256 p0 = GradAVX2(LookUpAVX2(perm, AA), fx, fy, fz);
+			const __m256 p1 = GradAVX2(LookUpAVX2(perm, BA), fx1, fy, fz);
+			const __m256 p2 = GradAVX2(LookUpAVX2(perm, AB), fx, fy1, fz);
+			const __m256 p3 = GradAVX2(LookUpAVX2(perm, BB), fx1, fy1, fz);
+			const __m256 p4 = GradAVX2(LookUpAVX2(perm, _mm256_and_si256(_mm256_add_epi32(AA, one), mask)), fx, fy, fz1);
+			const __m256 p5 = GradAVX2(LookUpAVX2(perm, _mm256_and_si256(_mm256_add_epi32(BA, one), mask)), fx1, fy, fz1);
+			const __m256 p6 = GradAVX2(LookUpAVX2(perm, _mm256_and_si256(_mm256_add_epi32(AB, one), mask)), fx, fy1, fz1);
+			const __m256 p7 = GradAVX2(LookUpAVX2(perm, _mm256_and_si256(_mm256_add_epi32(BB, one), mask)), fx1, fy1, fz1);
+
+			const __m256 r0 = LerpAVX2(LerpAVX2(p0, p1, u), LerpAVX2(p2, p3, u), v);
+			const __m256 r1 = LerpAVX2(LerpAVX2(p4, p5, u), LerpAVX2(p6, p7, u), v);
+			const __m256 result = LerpAVX2(r0, r1, w);
+			_mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_mul_ps(result, _mm256_set1_ps(0.5f)), _mm256_set1_ps(0.5f)));
+		}
+	}
+#endif
 }
 
-PerlinNoise::PerlinNoise() {
+PerlinNoise::PerlinNoise(uint64_t seed) {
 	std::copy(s_permutations.begin(), s_permutations.end(), m_permutations.begin());
-	std::copy(s_permutations.begin(), s_permutations.end(), m_permutations.begin() + 256);
+	if (seed != 0) {
+		// Fisher-Yates; std::shuffle daje różne wyniki w różnych bibliotekach
+		Random random(seed);
+		for (uint32_t i = 255; i > 0; --i)
+			std::swap(m_permutations[i], m_permutations[random.Below(i + 1)]);
+	}
+	std::copy(m_permutations.begin(), m_permutations.begin() + 256, m_permutations.begin() + 256);
+	WidenHashes();
+}
+
+void PerlinNoise::WidenHashes() {
+	std::copy(m_permutations.begin(), m_permutations.begin() + 256, m_hashes.begin());
 }
 
-PerlinNoise::PerlinNoise(float seed) {
-    std::iota(m_permutations.begin(), m_permutations.begin() + 256, 0); // Fill with 0-255
-    std::default_random_engine engine(static_cast<unsigned int>(seed));
-    std::shuffle(m_permutations.begin(), m_permutations.begin() + 256, engine);
-    std::copy(m_permutations.begin(), m_permutations.begin() + 256, m_permutations.begin() + 256);
+PerlinNoise::Path PerlinNoise::BestPath() {
+#ifdef PERLIN_NOISE_X86
+	static const Path s_best = __builtin_cpu_supports("avx2") ? Path::AVX2
+		: __builtin_cpu_supports("sse4.1") ? Path::SSE41 : Path::Scalar;
+	return s_best;
+#else
+	return Path::Scalar;
+#endif
+}
+
+void PerlinNoise::AtBatch(std::span<const float> xs, std::span<const float> ys, std::span<const float> zs, std::span<float> out) const {
+	AtBatch(xs, ys, zs, out, BestPath());
+}
+
+void PerlinNoise::AtBatch(std::span<const float> xs, std::span<const float> ys, std::span<const float> zs, std::span<float> out, Path path) const {
+	const size_t count = std::min({xs.size(), ys.size(), zs.size(), out.size()});
+	size_t done = 0;
+#ifdef PERLIN_NOISE_X86
+	if (path == Path::AVX2) {
+		AtBatchAVX2(m_hashes.data(), xs.data(), ys.data(), zs.data(), out.data(), count);
+		done = count - count % 8;
+	}
+	else if (path == Path::SSE41) {
+		AtBatchSSE(m_hashes.data(), xs.data(), ys.data(), zs.data(), out.data(), count);
+		done = count - count % 4;
+	}
+#endif
+	// Reszta, która nie wypełnia całego wektora
+	for (size_t i = done; i < count; ++i)
+		out[i] = At(glm::vec3(xs[i], ys[i], zs[i]));
 }
 
 float PerlinNoise::At(const glm::vec3& coords) const {
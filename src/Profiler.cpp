@@ -0,0 +1,300 @@
+#include "../include/Profiler.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+  using Clock = std::chrono::steady_clock;
+  const Clock::time_point s_epoch = Clock::now();
+
+  // Events of one thread, written only by it. A log outlives its thread, so
+  // traces keep the work of threads that already finished, and is handed to
+  // the next new thread after that.
+  struct ThreadLog
+  {
+    // A slot's fields are atomics so another thread may read them while the
+    // writer overwrites the slot; m_sequence tells whether it did
+    struct Slot
+    {
+      std::atomic<uint64_t> m_sequence{0}; // Index of the event + 1, 0 while it is written
+      std::atomic<const char *> m_name{nullptr};
+      std::atomic<uint64_t> m_start{0};
+      std::atomic<uint64_t> m_duration{0};
+    };
+
+    std::string m_name; // Under s_logsMutex
+    std::unique_ptr<Slot[]> m_slots = std::make_unique<Slot[]>(Profiler::s_capacity);
+    std::atomic<uint64_t> m_count{0}; // Events ever written, the ring keeps the last s_capacity
+    bool m_inUse{true};
+    bool m_gpu{false};
+
+    void Push(const Profiler::Event &event)
+    {
+      const uint64_t count = m_count.load(std::memory_order_relaxed);
+      Slot &slot = m_slots[count & (Profiler::s_capacity - 1)];
+      slot.m_sequence.store(0, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      slot.m_name.store(event.m_name, std::memory_order_relaxed);
+      slot.m_start.store(event.m_start, std::memory_order_relaxed);
+      slot.m_duration.store(event.m_duration, std::memory_order_relaxed);
+      slot.m_sequence.store(count + 1, std::memory_order_release);
+      m_count.store(count + 1, std::memory_order_release);
+    }
+
+    // Slots the writer overwrote or is overwriting while another thread
+    // reads them are left out
+    void Snapshot(std::vector<Profiler::Event> &events) const
+    {
+      const uint64_t count = m_count.load(std::memory_order_acquire);
+      const uint64_t first = count > Profiler::s_capacity ? count - Profiler::s_capacity : 0;
+      events.clear();
+      for (uint64_t i = first; i < count; ++i)
+      {
+        const Slot &slot = m_slots[i & (Profiler::s_capacity - 1)];
+        const uint64_t sequence = slot.m_sequence.load(std::memory_order_acquire);
+        if (sequence != i + 1)
+          continue;
+        const Profiler::Event event{slot.m_name.load(std::memory_order_relaxed), slot.m_start.load(std::memory_order_relaxed),
+                                    slot.m_duration.load(std::memory_order_relaxed)};
+        // Jeśli pisarz zaczął nadpisywać slot, numer już nie jest ten sam
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.m_sequence.load(std::memory_order_relaxed) == sequence)
+          events.push_back(event);
+      }
+    }
+  };
+
+  std::mutex s_logsMutex;
+  std::vector<std::unique_ptr<ThreadLog>> s_logs;
+  ThreadLog *s_gpuLog = nullptr;
+
+  // Starts of the last frames, main thread only
+  std::array<uint64_t, Profiler::s_frameHistory + 1> s_frames;
+  uint64_t s_frameCount = 0;
+
+  ThreadLog *Acquire()
+  {
+    std::lock_guard<std::mutex> lock(s_logsMutex);
+    for (auto &log : s_logs)
+    {
+      if (!log->m_inUse && !log->m_gpu)
+      {
+        log->m_inUse = true;
+        return log.get();
+      }
+    }
+    s_logs.push_back(std::make_unique<ThreadLog>());
+    s_logs.back()->m_name = "Thread " + std::to_string(s_logs.size());
+    return s_logs.back().get();
+  }
+
+  struct LogHandle
+  {
+    ThreadLog *m_log = nullptr;
+
+    ThreadLog &Get()
+    {
+      if (!m_log)
+        m_log = Acquire();
+      return *m_log;
+    }
+
+    ~LogHandle()
+    {
+      if (!m_log)
+        return;
+      std::lock_guard<std::mutex> lock(s_logsMutex);
+      m_log->m_inUse = false;
+    }
+  };
+
+  thread_local LogHandle t_log;
+
+  // With names, when asked for, taken under the same lock
+  std::vector<ThreadLog *> Logs(std::vector<std::string> *names = nullptr)
+  {
+    std::lock_guard<std::mutex> lock(s_logsMutex);
+    std::vector<ThreadLog *> logs;
+    for (const auto &log : s_logs)
+    {
+      logs.push_back(log.get());
+      if (names)
+        names->push_back(log->m_name);
+    }
+    return logs;
+  }
+
+  void WriteString(std::ostream &out, const std::string &text)
+  {
+    out << '"';
+    for (char c : text)
+    {
+      if (c == '"' || c == '\\')
+        out << '\\';
+      out << c;
+    }
+    out << '"';
+  }
+}
+
+void Profiler::SetEnabled(bool enabled)
+{
+  s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+uint64_t Profiler::Now()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - s_epoch).count();
+}
+
+void Profiler::SetThreadName(const std::string &name)
+{
+  ThreadLog &log = t_log.Get();
+  std::lock_guard<std::mutex> lock(s_logsMutex);
+  log.m_name = name;
+}
+
+void Profiler::BeginFrame()
+{
+  if (!Enabled())
+  {
+    s_frameCount = 0;
+    return;
+  }
+
+  const uint64_t now = Now();
+  if (s_frameCount > 0)
+  {
+    const uint64_t last = s_frames[(s_frameCount - 1) % s_frames.size()];
+    Record("Frame", last, now - last);
+  }
+  s_frames[s_frameCount % s_frames.size()] = now;
+  ++s_frameCount;
+}
+
+void Profiler::Record(const char *name, uint64_t start, uint64_t duration)
+{
+  t_log.Get().Push({name, start, duration});
+}
+
+void Profiler::RecordGpu(const char *name, uint64_t start, uint64_t duration)
+{
+  if (!s_gpuLog)
+  {
+    std::lock_guard<std::mutex> lock(s_logsMutex);
+    s_logs.push_back(std::make_unique<ThreadLog>());
+    s_gpuLog = s_logs.back().get();
+    s_gpuLog->m_name = "GPU";
+    s_gpuLog->m_gpu = true;
+  }
+  s_gpuLog->Push({name, start, duration});
+}
+
+void Profiler::PrintSummary(std::ostream &out)
+{
+  const size_t frames = std::min<uint64_t>(s_frameCount, s_frames.size());
+  if (frames < 2)
+  {
+    out << "Profiler: no complete frame yet" << std::endl;
+    return;
+  }
+
+  std::vector<uint64_t> starts;
+  for (uint64_t i = s_frameCount - frames; i < s_frameCount; ++i)
+    starts.push_back(s_frames[i % s_frames.size()]);
+
+  // Czas każdej strefy w każdej z pełnych klatek okna
+  struct Stats
+  {
+    std::vector<uint64_t> m_perFrame;
+    uint64_t m_calls{0};
+  };
+  std::map<std::string, Stats> zones;
+  std::vector<Event> events;
+  for (const ThreadLog *log : Logs())
+  {
+    log->Snapshot(events);
+    for (const Event &event : events)
+    {
+      if (event.m_start < starts.front() || event.m_start >= starts.back())
+        continue;
+      Stats &stats = zones[log->m_gpu ? "GPU " + std::string(event.m_name) : std::string(event.m_name)];
+      stats.m_perFrame.resize(frames - 1, 0);
+      const size_t frame = std::upper_bound(starts.begin(), starts.end(), event.m_start) - starts.begin() - 1;
+      stats.m_perFrame[frame] += event.m_duration;
+      ++stats.m_calls;
+    }
+  }
+
+  struct Row
+  {
+    std::string m_name;
+    double m_mean, m_max, m_calls;
+  };
+  std::vector<Row> rows;
+  for (const auto &[name, stats] : zones)
+  {
+    uint64_t total = 0;
+    for (uint64_t time : stats.m_perFrame)
+      total += time;
+    const uint64_t max = *std::max_element(stats.m_perFrame.begin(), stats.m_perFrame.end());
+    rows.push_back({name, total * 1e-6 / (frames - 1), max * 1e-6, static_cast<double>(stats.m_calls) / (frames - 1)});
+  }
+  std::sort(rows.begin(), rows.end(), [](const Row &a, const Row &b)
+            { return a.m_mean > b.m_mean; });
+
+  out << "Profile of the last " << frames - 1 << " frames, ms per frame:\n"
+      << std::left << std::setw(32) << "zone" << std::right << std::setw(10) << "mean" << std::setw(10) << "max" << std::setw(10) << "calls" << "\n";
+  out << std::fixed << std::setprecision(3);
+  for (const Row &row : rows)
+    out << std::left << std::setw(32) << row.m_name << std::right << std::setw(10) << row.m_mean << std::setw(10) << row.m_max << std::setw(10) << std::setprecision(1) << row.m_calls << std::setprecision(3) << "\n";
+  out << std::defaultfloat << std::flush;
+}
+
+bool Profiler::WriteTrace(const std::filesystem::path &path)
+{
+  std::ofstream out(path);
+  if (!out)
+  {
+    std::cerr << "Profiler: cannot write " << path << std::endl;
+    return false;
+  }
+
+  // Trace Event Format: nazwy wątków ("M") i pełne zdarzenia ("X"), czasy w mikrosekundach
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  out << std::fixed << std::setprecision(3);
+  std::vector<Event> events;
+  std::vector<std::string> names;
+  const std::vector<ThreadLog *> logs = Logs(&names);
+  for (size_t tid = 0; tid < logs.size(); ++tid)
+  {
+    out << (tid == 0 ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid << ",\"args\":{\"name\":";
+    WriteString(out, names[tid]);
+    out << "}}";
+
+    logs[tid]->Snapshot(events);
+    for (const Event &event : events)
+    {
+      out << ",\n{\"name\":";
+      WriteString(out, event.m_name);
+      out << ",\"cat\":\"" << (logs[tid]->m_gpu ? "gpu" : "cpu") << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+          << ",\"ts\":" << event.m_start * 1e-3 << ",\"dur\":" << event.m_duration * 1e-3 << "}";
+    }
+  }
+  out << "\n]}\n";
+
+  if (!out)
+  {
+    std::cerr << "Profiler: cannot write " << path << std::endl;
+    return false;
+  }
+  return true;
+}
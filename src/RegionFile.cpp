@@ -0,0 +1,303 @@
+#include "../include/RegionFile.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static_assert(RegionFile::s_regionSize == 32, "RegionStore::RegionCoords shifts by 5");
+
+namespace
+{
+	constexpr char s_magic[4] = {'M', 'C', 'R', 'G'};
+	constexpr uint32_t s_version = 1;
+	constexpr size_t s_headerSize = 16;
+	constexpr size_t s_tableSize = RegionFile::s_chunkCount * 8;
+
+	// Liczby w pliku zawsze little-endian, niezależnie od maszyny
+	void PutU16(uint8_t *out, uint16_t value)
+	{
+		out[0] = static_cast<uint8_t>(value);
+		out[1] = static_cast<uint8_t>(value >> 8);
+	}
+
+	void PutU32(uint8_t *out, uint32_t value)
+	{
+		for (int i = 0; i < 4; ++i)
+			out[i] = static_cast<uint8_t>(value >> (8 * i));
+	}
+
+	uint16_t GetU16(const uint8_t *in)
+	{
+		return static_cast<uint16_t>(in[0] | (in[1] << 8));
+	}
+
+	uint32_t GetU32(const uint8_t *in)
+	{
+		uint32_t value = 0;
+		for (int i = 0; i < 4; ++i)
+			value |= static_cast<uint32_t>(in[i]) << (8 * i);
+		return value;
+	}
+
+	bool WriteAll(int fd, const uint8_t *data, size_t size)
+	{
+		while (size > 0)
+		{
+			const ssize_t written = ::write(fd, data, size);
+			if (written < 0)
+			{
+				if (errno == EINTR)
+					continue;
+				return false;
+			}
+			data += written;
+			size -= static_cast<size_t>(written);
+		}
+		return true;
+	}
+
+	uint64_t RegionKey(const glm::ivec2 &region)
+	{
+		return (static_cast<uint64_t>(static_cast<uint32_t>(region.x)) << 32) | static_cast<uint32_t>(region.y);
+	}
+
+	// Rename jest trwały dopiero po fsync katalogu
+	void SyncDirectory(const std::filesystem::path &directory)
+	{
+		const int fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY);
+		if (fd < 0)
+			return;
+		::fsync(fd);
+		::close(fd);
+	}
+}
+
+RegionFile::RegionFile(std::filesystem::path path, const glm::ivec3 &chunkSize)
+	: m_path(std::move(path)), m_chunkSize(chunkSize)
+{
+	Map();
+}
+
+RegionFile::~RegionFile()
+{
+	Unmap();
+}
+
+bool RegionFile::Read(const glm::ivec2 &local, std::span<Cube::Type> blocks) const
+{
+	const std::span<const uint8_t> payload = Payload(LocalIndex(local));
+	if (payload.empty())
+		return false;
+
+	if (!Decode(payload, blocks))
+	{
+		std::cerr << "RegionFile: damaged chunk " << local.x << ", " << local.y << " in " << m_path << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool RegionFile::Write(const std::unordered_map<int, std::vector<uint8_t>> &chunks)
+{
+	if (!m_valid)
+	{
+		std::cerr << "RegionFile: refusing to overwrite " << m_path << ", it is not a compatible region" << std::endl;
+		return false;
+	}
+
+	// Nowy plik: podane chunki plus wszystkie pozostałe ze starego mapowania
+	std::vector<uint8_t> file(s_headerSize + s_tableSize, 0);
+	std::memcpy(file.data(), s_magic, sizeof(s_magic));
+	PutU32(file.data() + 4, s_version);
+	PutU16(file.data() + 8, static_cast<uint16_t>(m_chunkSize.x));
+	PutU16(file.data() + 10, static_cast<uint16_t>(m_chunkSize.y));
+	PutU16(file.data() + 12, static_cast<uint16_t>(m_chunkSize.z));
+
+	for (int i = 0; i < s_chunkCount; ++i)
+	{
+		std::span<const uint8_t> payload;
+		auto it = chunks.find(i);
+		if (it != chunks.end())
+			payload = it->second;
+		else
+			payload = Payload(i);
+		if (payload.empty())
+			continue;
+
+		PutU32(file.data() + s_headerSize + i * 8, static_cast<uint32_t>(file.size()));
+		PutU32(file.data() + s_headerSize + i * 8 + 4, static_cast<uint32_t>(payload.size()));
+		file.insert(file.end(), payload.begin(), payload.end());
+	}
+
+	std::filesystem::path temporary = m_path;
+	temporary += ".tmp";
+	const int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+	{
+		std::cerr << "RegionFile: cannot create " << temporary << ": " << std::strerror(errno) << std::endl;
+		return false;
+	}
+	const bool written = WriteAll(fd, file.data(), file.size()) && ::fsync(fd) == 0;
+	::close(fd);
+	if (!written || ::rename(temporary.c_str(), m_path.c_str()) != 0)
+	{
+		std::cerr << "RegionFile: cannot write " << m_path << ": " << std::strerror(errno) << std::endl;
+		::unlink(temporary.c_str());
+		return false;
+	}
+	SyncDirectory(m_path.parent_path());
+
+	Unmap();
+	Map();
+	return true;
+}
+
+void RegionFile::Encode(std::span<const Cube::Type> blocks, std::vector<uint8_t> &out)
+{
+	out.clear();
+	for (size_t i = 0; i < blocks.size();)
+	{
+		size_t run = 1;
+		while (i + run < blocks.size() && blocks[i + run] == blocks[i])
+			++run;
+
+		out.push_back(static_cast<uint8_t>(blocks[i]));
+		for (size_t value = run; true; value >>= 7)
+		{
+			if (value < 0x80)
+			{
+				out.push_back(static_cast<uint8_t>(value));
+				break;
+			}
+			out.push_back(static_cast<uint8_t>(value & 0x7F) | 0x80);
+		}
+		i += run;
+	}
+}
+
+bool RegionFile::Decode(std::span<const uint8_t> data, std::span<Cube::Type> blocks)
+{
+	size_t filled = 0;
+	for (size_t i = 0; i < data.size();)
+	{
+		const uint8_t type = data[i++];
+		if (type >= Cube::s_typeCount)
+			return false;
+
+		size_t run = 0;
+		for (int shift = 0;; shift += 7)
+		{
+			if (i == data.size() || shift > 28)
+				return false;
+			const uint8_t byte = data[i++];
+			run |= static_cast<size_t>(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0)
+				break;
+		}
+
+		if (run == 0 || run > blocks.size() - filled)
+			return false;
+		std::fill_n(blocks.begin() + filled, run, static_cast<Cube::Type>(type));
+		filled += run;
+	}
+	return filled == blocks.size();
+}
+
+void RegionFile::Map()
+{
+	m_valid = true;
+	const int fd = ::open(m_path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return; // Brak pliku to pusty region
+
+	struct stat info;
+	if (::fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= s_headerSize + s_tableSize)
+	{
+		void *data = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data != MAP_FAILED)
+		{
+			m_data = static_cast<const uint8_t *>(data);
+			m_size = static_cast<size_t>(info.st_size);
+		}
+	}
+	::close(fd);
+
+	m_valid = m_data && std::memcmp(m_data, s_magic, sizeof(s_magic)) == 0 && GetU32(m_data + 4) == s_version &&
+			  GetU16(m_data + 8) == m_chunkSize.x && GetU16(m_data + 10) == m_chunkSize.y && GetU16(m_data + 12) == m_chunkSize.z;
+	if (!m_valid)
+	{
+		std::cerr << "RegionFile: " << m_path << " is not a region of " << m_chunkSize.x << "x" << m_chunkSize.y << "x"
+				  << m_chunkSize.z << " chunks" << std::endl;
+		Unmap();
+	}
+}
+
+void RegionFile::Unmap()
+{
+	if (m_data)
+		::munmap(const_cast<uint8_t *>(m_data), m_size);
+	m_data = nullptr;
+	m_size = 0;
+}
+
+std::span<const uint8_t> RegionFile::Payload(int index) const
+{
+	if (!m_data)
+		return {};
+
+	const uint8_t *entry = m_data + s_headerSize + static_cast<size_t>(index) * 8;
+	const size_t offset = GetU32(entry);
+	const size_t length = GetU32(entry + 4);
+	if (length == 0 || offset < s_headerSize + s_tableSize || offset > m_size || length > m_size - offset)
+		return {};
+	return std::span<const uint8_t>(m_data + offset, length);
+}
+
+RegionStore::RegionStore(std::filesystem::path directory, const glm::ivec3 &chunkSize)
+	: m_directory(std::move(directory)), m_chunkSize(chunkSize)
+{
+	std::error_code error;
+	std::filesystem::create_directories(m_directory, error);
+	if (error)
+		std::cerr << "RegionStore: cannot create " << m_directory << ": " << error.message() << std::endl;
+}
+
+bool RegionStore::Load(const glm::ivec2 &coords, std::span<Cube::Type> blocks)
+{
+	return Region(RegionCoords(coords)).Read(LocalCoords(coords), blocks);
+}
+
+bool RegionStore::Save(std::span<const StoredChunk> chunks)
+{
+	// Grupujemy po regionach, żeby każdy plik zapisać tylko raz
+	std::unordered_map<uint64_t, std::pair<glm::ivec2, std::unordered_map<int, std::vector<uint8_t>>>> regions;
+	for (const StoredChunk &chunk : chunks)
+	{
+		const glm::ivec2 region = RegionCoords(chunk.m_coords);
+		auto &[coords, encoded] = regions[RegionKey(region)];
+		coords = region;
+		RegionFile::Encode(chunk.m_blocks, encoded[RegionFile::LocalIndex(LocalCoords(chunk.m_coords))]);
+	}
+
+	bool saved = true;
+	for (const auto &[key, region] : regions)
+		saved = Region(region.first).Write(region.second) && saved;
+	return saved;
+}
+
+RegionFile &RegionStore::Region(const glm::ivec2 &region)
+{
+	std::unique_ptr<RegionFile> &file = m_regions[RegionKey(region)];
+	if (!file)
+	{
+		const std::string name = "r." + std::to_string(region.x) + "." + std::to_string(region.y) + ".region";
+		file = std::make_unique<RegionFile>(m_directory / name, m_chunkSize);
+	}
+	return *file;
+}
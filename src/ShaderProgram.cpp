@@ -1,32 +1,95 @@
 #include "../include/ShaderProgram.hpp"
 #include <iostream>
 
+// In Uniform order
+const std::array<const char *, static_cast<size_t>(ShaderProgram::Uniform::Count)>
+    ShaderProgram::s_uniformNames = {"model", "blockLayers", "blocks"};
+
 std::string ShaderProgram::s_vertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in uvec4 aPosition; // x, y, z, face
+    layout (location = 1) in uvec4 aTile;     // offset inside the merged quad, type
+
+    out vec2 TileCoord;
+    flat out uint Face;
+    flat out float Layer;
+
+    layout (std140) uniform Camera {
+        mat4 view;
+        mat4 projection;
+    };
+    uniform mat4 model;
+    uniform int blockLayers[4]; // Cube::s_typeCount
+
+    void main() {
+        gl_Position = projection * view * model * vec4(vec3(aPosition.xyz), 1.0);
+        TileCoord = vec2(aTile.xy);
+        Face = aPosition.w;
+        Layer = float(blockLayers[aTile.z]);
+    })";
+
+std::string ShaderProgram::s_fragmentShaderSource = R"(
+    #version 330 core
+    out vec4 FragColor;
+
+    in vec2 TileCoord;
+    flat in uint Face;
+    flat in float Layer;
+
+    uniform sampler2DArray blocks;
+
+    // Sub-rectangle of each face in the block texture, in Cube::Face order
+    const vec2 faceOrigin[6] = vec2[6](
+        vec2(0.25, 0.0), vec2(0.25, 1.0), vec2(0.75, 1.0 / 3.0),
+        vec2(0.0, 1.0 / 3.0), vec2(0.75, 2.0 / 3.0), vec2(0.5, 1.0 / 3.0));
+    const vec2 faceU[6] = vec2[6](
+        vec2(0.25, 0.0), vec2(0.25, 0.0), vec2(-0.25, 0.0),
+        vec2(0.25, 0.0), vec2(0.25, 0.0), vec2(-0.25, 0.0));
+    const vec2 faceV[6] = vec2[6](
+        vec2(0.0, 1.0 / 3.0), vec2(0.0, -1.0 / 3.0), vec2(0.0, 1.0 / 3.0),
+        vec2(0.0, 1.0 / 3.0), vec2(0.0, -1.0 / 3.0), vec2(0.0, 1.0 / 3.0));
+
+    void main() {
+        // Repeat the face once per block of a merged quad; gradients come from
+        // the unwrapped coordinates so mip selection does not break at seams
+        vec2 local = fract(TileCoord);
+        vec2 uv = faceOrigin[Face] + local.x * faceU[Face] + local.y * faceV[Face];
+        vec2 dx = dFdx(TileCoord.x) * faceU[Face] + dFdx(TileCoord.y) * faceV[Face];
+        vec2 dy = dFdy(TileCoord.x) * faceU[Face] + dFdy(TileCoord.y) * faceV[Face];
+        FragColor = textureGrad(blocks, vec3(uv, Layer), dx, dy);
+    })";
+
+std::string ShaderProgram::s_instancedVertexShaderSource = R"(
     #version 330 core
     layout (location = 0) in vec3 aPos;
     layout (location = 1) in vec2 aTexCoord;
+    layout (location = 2) in uvec4 aOffset; // block inside the chunk and its type, per instance
 
-    out vec2 TexCoord;
+    out vec3 TexCoord;
 
+    layout (std140) uniform Camera {
+        mat4 view;
+        mat4 projection;
+    };
     uniform mat4 model;
-    uniform mat4 view;
-    uniform mat4 projection;
+    uniform int blockLayers[4]; // Cube::s_typeCount
 
     void main() {
-        gl_Position = projection * view * model *vec4(aPos, 1.0);
-        TexCoord = aTexCoord;
+        // Cube vertices are centred on the origin, blocks span [offset, offset + 1]
+        gl_Position = projection * view * model * vec4(aPos + vec3(aOffset.xyz) + 0.5, 1.0);
+        TexCoord = vec3(aTexCoord, float(blockLayers[aOffset.w]));
     })";
 
-std::string ShaderProgram::s_fragmentShaderSource = R"(
+std::string ShaderProgram::s_instancedFragmentShaderSource = R"(
     #version 330 core
     out vec4 FragColor;
 
-    in vec2 TexCoord;
+    in vec3 TexCoord;
 
-    uniform sampler2D texture1;
+    uniform sampler2DArray blocks;
 
     void main() {
-        FragColor = texture(texture1, TexCoord);
+        FragColor = texture(blocks, TexCoord);
     })";
 
 GLuint ShaderProgram::createShader(const GLchar *shaderSource,
@@ -67,9 +130,44 @@ GLuint ShaderProgram::createProgram(GLuint vertexShader, GLuint fragmentShader,
     glAttachShader(programId, geometryShader);
 
   glLinkProgram(programId);
+
+  GLint success;
+  glGetProgramiv(programId, GL_LINK_STATUS, &success);
+  if (!success)
+  {
+    GLchar infoLog[512];
+    glGetProgramInfoLog(programId, 512, nullptr, infoLog);
+    std::cerr << "ERROR: Shader Program Linking Failed\n"
+              << infoLog << std::endl;
+    glDeleteProgram(programId);
+    programId = 0;
+  }
+
   return programId;
 }
 
+void ShaderProgram::resolveUniforms()
+{
+  for (size_t i = 0; i < s_uniformNames.size(); ++i)
+  {
+    m_locations[i] = glGetUniformLocation(programId, s_uniformNames[i]);
+    if (m_locations[i] == -1)
+      std::cerr << "Uniform '" << s_uniformNames[i]
+                << "' not found in shader program!" << std::endl;
+  }
+
+  const GLuint cameraBlock = glGetUniformBlockIndex(programId, "Camera");
+  if (cameraBlock != GL_INVALID_INDEX)
+    glUniformBlockBinding(programId, cameraBlock, s_cameraBinding);
+  else
+    std::cerr << "Uniform block 'Camera' not found in shader program!"
+              << std::endl;
+
+  // Tablica tekstur zawsze na jednostce 0
+  use();
+  setUniform(Uniform::Blocks, 0);
+}
+
 std::pair<GLuint, GLuint> ShaderProgram::createVertexBufferObject()
 {
   const float triangle[] = {
@@ -94,13 +192,20 @@ std::pair<GLuint, GLuint> ShaderProgram::createVertexBufferObject()
   return std::make_pair(vbo, vao);
 }
 
-ShaderProgram::ShaderProgram()
+ShaderProgram::ShaderProgram(Variant variant)
 {
-  vertexShader = createShader(s_vertexShaderSource.c_str(), GL_VERTEX_SHADER);
-  fragmentShader = createShader(s_fragmentShaderSource.c_str(), GL_FRAGMENT_SHADER);
+  const bool instanced = variant == Variant::Instanced;
+  const GLuint vertexShader = createShader(
+      (instanced ? s_instancedVertexShaderSource : s_vertexShaderSource).c_str(), GL_VERTEX_SHADER);
+  const GLuint fragmentShader = createShader(
+      (instanced ? s_instancedFragmentShaderSource : s_fragmentShaderSource).c_str(), GL_FRAGMENT_SHADER);
   programId = createProgram(vertexShader, fragmentShader);
+  // Program trzyma je, dopóki istnieje
   glDeleteShader(vertexShader);
   glDeleteShader(fragmentShader);
+
+  if (programId != 0)
+    resolveUniforms();
 }
 
 void ShaderProgram::cleanUp(std::pair<GLuint, GLuint> vv)
@@ -108,12 +213,11 @@ void ShaderProgram::cleanUp(std::pair<GLuint, GLuint> vv)
   glDeleteVertexArrays(1, &vv.second);
   glDeleteBuffers(1, &vv.first);
   glDeleteProgram(programId);
-  glDeleteShader(vertexShader);
-  glDeleteShader(fragmentShader);
+  programId = 0;
 }
 
 ShaderProgram::ShaderProgram(ShaderProgram &&rhs) noexcept
-    : programId(std::exchange(rhs.programId, 0)) {}
+    : programId(std::exchange(rhs.programId, 0)), m_locations(rhs.m_locations) {}
 
 ShaderProgram &ShaderProgram::operator=(ShaderProgram &&rhs) noexcept
 {
@@ -122,24 +226,38 @@ ShaderProgram &ShaderProgram::operator=(ShaderProgram &&rhs) noexcept
     return *this;
   }
 
+  glDeleteProgram(programId);
   programId = std::exchange(rhs.programId, 0);
+  m_locations = rhs.m_locations;
 
   return *this;
 }
 
 void ShaderProgram::use() { glUseProgram(programId); }
 
-void ShaderProgram::setUniform(const std::string &name,
-                               const glm::mat4 &matrix)
+// Nieznane uniformy mają lokalizację -1, którą GL po cichu ignoruje
+void ShaderProgram::setUniform(Uniform uniform, const glm::mat4 &matrix)
 {
-  GLint location = glGetUniformLocation(programId, name.c_str());
-  if (location != -1)
-  {
-    glUniformMatrix4fv(location, 1, GL_FALSE, &matrix[0][0]);
-  }
-  else
-  {
-    std::cerr << "Uniform '" << name << "' not found in shader program!"
-              << std::endl;
-  }
-}
\ No newline at end of file
+  glUniformMatrix4fv(location(uniform), 1, GL_FALSE, &matrix[0][0]);
+}
+
+void ShaderProgram::setUniform(Uniform uniform, const glm::vec3 &vector)
+{
+  glUniform3fv(location(uniform), 1, &vector[0]);
+}
+
+void ShaderProgram::setUniform(Uniform uniform, float value)
+{
+  glUniform1f(location(uniform), value);
+}
+
+void ShaderProgram::setUniform(Uniform uniform, GLint value)
+{
+  glUniform1i(location(uniform), value);
+}
+
+void ShaderProgram::setUniform(Uniform uniform, const GLint *values,
+                               GLsizei count)
+{
+  glUniform1iv(location(uniform), count, values);
+}
@@ -0,0 +1,289 @@
+#include "../include/TerrainGenerator.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	size_t BlockIndex(const glm::ivec3 &size, int x, int y, int z)
+	{
+		return (static_cast<size_t>(y) * size.x + x) * size.z + z;
+	}
+
+	// Solid blocks with air (or the sky) right above them become grass
+	void CoverWithGrass(const glm::ivec3 &size, std::span<Cube::Type> blocks)
+	{
+		for (int y = 0; y < size.y; ++y)
+		{
+			for (int x = 0; x < size.x; ++x)
+			{
+				for (int z = 0; z < size.z; ++z)
+				{
+					Cube::Type &block = blocks[BlockIndex(size, x, y, z)];
+					if (block == Cube::Type::None)
+						continue;
+					const bool open = y + 1 == size.y || blocks[BlockIndex(size, x, y + 1, z)] == Cube::Type::None;
+					block = open ? Cube::Type::Grass : Cube::Type::Stone;
+				}
+			}
+		}
+	}
+}
+
+HeightmapGenerator::HeightmapGenerator(uint64_t seed) : TerrainGenerator(seed), m_noise(seed) {}
+
+void HeightmapGenerator::Generate(const glm::ivec3 &size, int worldX, int worldZ, std::span<Cube::Type> blocks) const
+{
+	const int width = size.x;
+	const int height = size.y;
+	const int depth = size.z;
+
+	// Najpierw mapa wysokości: szum liczony raz na kolumnę, całą paczką
+	const size_t columns = static_cast<size_t>(width) * depth;
+	std::vector<float> noiseX(columns), noiseY(columns), noiseZ(columns), heights(columns);
+	for (int x = 0; x < width; ++x)
+	{
+		for (int z = 0; z < depth; ++z)
+		{
+			const glm::vec3 coords = glm::vec3(static_cast<float>(worldX) + x, static_cast<float>(worldZ) + z, 0) * 0.1f;
+			noiseX[x * depth + z] = coords.x;
+			noiseY[x * depth + z] = coords.y;
+			noiseZ[x * depth + z] = coords.z;
+		}
+	}
+	m_noise.AtBatch(noiseX, noiseY, noiseZ, heights);
+	for (float &columnHeight : heights)
+		columnHeight *= height;
+
+	// Kolumna nie wystaje więcej niż o jeden blok ponad lewą i przednią sąsiadkę
+	std::vector<size_t> maxHeights(columns);
+	for (int x = 0; x < width; ++x)
+	{
+		for (int z = 0; z < depth; ++z)
+		{
+			size_t maxHeight = static_cast<size_t>(heights[x * depth + z]);
+			if (x > 0)
+				maxHeight = std::min(maxHeight, static_cast<size_t>(heights[(x - 1) * depth + z] + 1));
+			if (z > 0)
+				maxHeight = std::min(maxHeight, static_cast<size_t>(heights[x * depth + z - 1] + 1));
+			maxHeights[x * depth + z] = maxHeight;
+		}
+	}
+
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			for (int z = 0; z < depth; ++z)
+			{
+				const size_t maxHeight = maxHeights[x * depth + z];
+				Cube::Type &block = blocks[BlockIndex(size, x, y, z)];
+				if (static_cast<size_t>(y) < maxHeight)
+					block = Cube::Type::Stone;
+				else if (static_cast<size_t>(y) == maxHeight)
+					block = Cube::Type::Grass;
+				else
+					block = Cube::Type::None;
+			}
+		}
+	}
+}
+
+FractalGenerator::FractalGenerator(const TerrainSettings &settings, uint64_t seed)
+	: TerrainGenerator(seed), m_settings(settings), m_noise(seed) {}
+
+void FractalGenerator::FillHeights(int worldX, int worldZ, int width, int depth, std::vector<float> &heights) const
+{
+	const size_t columns = static_cast<size_t>(width) * depth;
+	std::vector<float> xs(columns), zs(columns), octave(columns), samples(columns);
+	std::vector<float> fbm(columns, 0.0f), ridged(columns, 0.0f);
+
+	float frequency = m_settings.m_frequency;
+	float amplitude = 1.0f;
+	float amplitudeSum = 0.0f;
+	for (int o = 0; o < m_settings.m_octaves; ++o)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			for (int z = 0; z < depth; ++z)
+			{
+				xs[x * depth + z] = (worldX + x) * frequency;
+				zs[x * depth + z] = (worldZ + z) * frequency;
+			}
+		}
+		// Każda oktawa w innej płaszczyźnie szumu, żeby nie były skorelowane
+		std::fill(octave.begin(), octave.end(), 0.5f + o * 17.0f);
+		m_noise.AtBatch(xs, zs, octave, samples);
+
+		for (size_t i = 0; i < columns; ++i)
+		{
+			const float signedNoise = 2.0f * samples[i] - 1.0f;
+			const float ridge = 1.0f - std::fabs(signedNoise);
+			fbm[i] += amplitude * signedNoise;
+			ridged[i] += amplitude * ridge * ridge;
+		}
+
+		amplitudeSum += amplitude;
+		frequency *= m_settings.m_lacunarity;
+		amplitude *= m_settings.m_gain;
+	}
+
+	heights.resize(columns);
+	for (size_t i = 0; i < columns; ++i)
+	{
+		const float smooth = amplitudeSum > 0.0f ? fbm[i] / amplitudeSum : 0.0f;
+		const float sharp = amplitudeSum > 0.0f ? 2.0f * ridged[i] / amplitudeSum - 1.0f : 0.0f;
+		const float shape = smooth + (sharp - smooth) * m_settings.m_ridged;
+		heights[i] = m_settings.m_baseHeight + m_settings.m_heightScale * shape;
+	}
+}
+
+void FractalGenerator::Generate(const glm::ivec3 &size, int worldX, int worldZ, std::span<Cube::Type> blocks) const
+{
+	const int width = size.x;
+	const int height = size.y;
+	const int depth = size.z;
+	const int step = std::max(1, m_settings.m_latticeStep);
+
+	std::vector<float> heights;
+	FillHeights(worldX, worldZ, width, depth, heights);
+
+	const glm::ivec3 cells = (size + step - 1) / step;
+	const glm::ivec3 corners = cells + 1;
+	auto cornerIndex = [&corners](int x, int y, int z)
+	{ return (static_cast<size_t>(y) * corners.x + x) * corners.z + z; };
+
+	// Klasyfikacja komórek siatki. Szum 3D mieści się w [0, 1], więc przesunięcie
+	// powierzchni nie przekracza m_overhang, a interpolacja nie wychodzi poza narożniki.
+	enum class Cell : uint8_t { Air, Solid, Mixed };
+	std::vector<Cell> cellStates(static_cast<size_t>(cells.x) * cells.y * cells.z);
+	std::vector<uint8_t> needed(static_cast<size_t>(corners.x) * corners.y * corners.z, 0);
+	const bool caves = m_settings.m_caveWidth > 0.0f;
+	for (int cy = 0; cy < cells.y; ++cy)
+	{
+		for (int cx = 0; cx < cells.x; ++cx)
+		{
+			for (int cz = 0; cz < cells.z; ++cz)
+			{
+				float minHeight = std::numeric_limits<float>::max();
+				float maxHeight = std::numeric_limits<float>::lowest();
+				for (int x = cx * step; x < std::min(width, (cx + 1) * step); ++x)
+				{
+					for (int z = cz * step; z < std::min(depth, (cz + 1) * step); ++z)
+					{
+						minHeight = std::min(minHeight, heights[x * depth + z]);
+						maxHeight = std::max(maxHeight, heights[x * depth + z]);
+					}
+				}
+
+				const int yLow = cy * step;
+				const int yHigh = std::min(height, (cy + 1) * step) - 1;
+				const bool caveReach = caves && yHigh >= m_settings.m_caveFloor &&
+									   yLow < maxHeight - m_settings.m_caveRoof;
+
+				Cell state = Cell::Mixed;
+				if (yLow > maxHeight + m_settings.m_overhang)
+					state = Cell::Air;
+				else if (yHigh < minHeight - m_settings.m_overhang && !caveReach)
+					state = Cell::Solid;
+				cellStates[(static_cast<size_t>(cy) * cells.x + cx) * cells.z + cz] = state;
+
+				if (state != Cell::Mixed)
+					continue;
+				for (int corner = 0; corner < 8; ++corner)
+					needed[cornerIndex(cx + (corner & 1), cy + ((corner >> 1) & 1), cz + (corner >> 2))] = 1;
+			}
+		}
+	}
+
+	// Tylko potrzebne narożniki, jedną paczką na pole
+	std::vector<size_t> samples;
+	std::vector<float> xs, ys, zs;
+	for (int y = 0; y < corners.y; ++y)
+	{
+		for (int x = 0; x < corners.x; ++x)
+		{
+			for (int z = 0; z < corners.z; ++z)
+			{
+				if (!needed[cornerIndex(x, y, z)])
+					continue;
+				samples.push_back(cornerIndex(x, y, z));
+				xs.push_back(static_cast<float>(worldX + x * step));
+				ys.push_back(static_cast<float>(y * step));
+				zs.push_back(static_cast<float>(worldZ + z * step));
+			}
+		}
+	}
+
+	std::vector<float> overhang(needed.size(), 0.5f), cave(needed.size(), 0.5f);
+	if (!samples.empty())
+	{
+		std::vector<float> fx(samples.size()), fy(samples.size()), fz(samples.size()), values(samples.size());
+		auto sampleField = [&](float frequency, float offset, std::vector<float> &field)
+		{
+			for (size_t i = 0; i < samples.size(); ++i)
+			{
+				fx[i] = xs[i] * frequency + offset;
+				fy[i] = ys[i] * frequency;
+				fz[i] = zs[i] * frequency;
+			}
+			m_noise.AtBatch(fx, fy, fz, values);
+			for (size_t i = 0; i < samples.size(); ++i)
+				field[samples[i]] = values[i];
+		};
+		sampleField(m_settings.m_overhangFrequency, 0.0f, overhang);
+		if (caves)
+			sampleField(m_settings.m_caveFrequency, 101.5f, cave);
+	}
+
+	for (int cy = 0; cy < cells.y; ++cy)
+	{
+		for (int cx = 0; cx < cells.x; ++cx)
+		{
+			for (int cz = 0; cz < cells.z; ++cz)
+			{
+				const Cell state = cellStates[(static_cast<size_t>(cy) * cells.x + cx) * cells.z + cz];
+				for (int y = cy * step; y < std::min(height, (cy + 1) * step); ++y)
+				{
+					const float ty = static_cast<float>(y - cy * step) / step;
+					for (int x = cx * step; x < std::min(width, (cx + 1) * step); ++x)
+					{
+						const float tx = static_cast<float>(x - cx * step) / step;
+						for (int z = cz * step; z < std::min(depth, (cz + 1) * step); ++z)
+						{
+							Cube::Type &block = blocks[BlockIndex(size, x, y, z)];
+							if (state != Cell::Mixed)
+							{
+								block = state == Cell::Air ? Cube::Type::None : Cube::Type::Stone;
+								continue;
+							}
+
+							const float tz = static_cast<float>(z - cz * step) / step;
+							auto interpolate = [&](const std::vector<float> &field)
+							{
+								auto at = [&](int corner)
+								{ return field[cornerIndex(cx + (corner & 1), cy + ((corner >> 1) & 1), cz + (corner >> 2))]; };
+								const float x00 = at(0) + (at(1) - at(0)) * tx;
+								const float x10 = at(2) + (at(3) - at(2)) * tx;
+								const float x01 = at(4) + (at(5) - at(4)) * tx;
+								const float x11 = at(6) + (at(7) - at(6)) * tx;
+								const float y0 = x00 + (x10 - x00) * ty;
+								const float y1 = x01 + (x11 - x01) * ty;
+								return y0 + (y1 - y0) * tz;
+							};
+
+							const float surface = heights[x * depth + z];
+							const float density = surface - y + m_settings.m_overhang * (2.0f * interpolate(overhang) - 1.0f);
+							bool solid = density >= 0.0f;
+							if (solid && caves && y >= m_settings.m_caveFloor && y < surface - m_settings.m_caveRoof)
+								solid = std::fabs(interpolate(cave) - 0.5f) >= m_settings.m_caveWidth;
+							block = solid ? Cube::Type::Stone : Cube::Type::None;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	CoverWithGrass(size, blocks);
+}
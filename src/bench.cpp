@@ -0,0 +1,816 @@
+#include "../include/Chunk.hpp"
+#include "../include/PerlinNoise.hpp"
+#include "../include/Profiler.hpp"
+#include "../include/VoxelRay.hpp"
+#include "../include/World.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Headless benchmark of the world core: no window and no GL. Every run uses
+// the same seeds, so the work (and the checksums) match between runs and
+// machines. One JSON object per line on stdout, e.g. for jq or a spreadsheet:
+//   {"bench":"generate","items":256,"seconds":0.0123,"per_second":20812.6,...}
+
+namespace
+{
+  constexpr size_t chunkSize = 16;
+  constexpr uint64_t seed = 1337;
+  using World_t = World<chunkSize>;
+  using Chunk_t = World_t::Chunk_t;
+  using Clock = std::chrono::steady_clock;
+
+  double Seconds(Clock::time_point start)
+  {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+  }
+
+  // Pola w kolejności dodania, liczby bez notacji naukowej
+  class JsonLine
+  {
+  public:
+    explicit JsonLine(const std::string &bench) { Add("bench", bench); }
+
+    JsonLine &Add(const std::string &key, const std::string &value)
+    {
+      Key(key) << '"' << value << '"';
+      return *this;
+    }
+
+    JsonLine &Add(const std::string &key, double value)
+    {
+      Key(key) << value;
+      return *this;
+    }
+
+    // items in seconds, and their rate
+    JsonLine &Rate(size_t items, double seconds)
+    {
+      Add("items", static_cast<double>(items));
+      Add("seconds", seconds);
+      return Add("per_second", seconds > 0.0 ? items / seconds : 0.0);
+    }
+
+    ~JsonLine() { std::cout << m_out.str() << "}" << std::endl; }
+
+  private:
+    std::ostringstream m_out;
+    bool m_first{true};
+
+    std::ostringstream &Key(const std::string &key)
+    {
+      m_out << (m_first ? "{" : ",") << '"' << key << "\":";
+      m_first = false;
+      m_out.precision(10);
+      return m_out;
+    }
+  };
+
+  const char *PathName(PerlinNoise::Path path)
+  {
+    switch (path)
+    {
+    case PerlinNoise::Path::AVX2:
+      return "avx2";
+    case PerlinNoise::Path::SSE41:
+      return "sse41";
+    default:
+      return "scalar";
+    }
+  }
+
+  void BenchNoise()
+  {
+    const size_t samples = 1 << 20;
+    const PerlinNoise noise(seed);
+    Random random(seed, 1);
+    std::vector<float> xs(samples), ys(samples), zs(samples), out(samples);
+    for (size_t i = 0; i < samples; ++i)
+    {
+      // Ujemne współrzędne też, bo tam floor i obcięcie się różnią
+      xs[i] = (random.NextFloat() * 2.0f - 1.0f) * 256.0f;
+      ys[i] = (random.NextFloat() * 2.0f - 1.0f) * 16.0f;
+      zs[i] = (random.NextFloat() * 2.0f - 1.0f) * 256.0f;
+    }
+
+    // Każda ścieżka porównana bit w bit z At
+    std::vector<float> reference(samples);
+    double sum = 0.0;
+    auto start = Clock::now();
+    for (size_t i = 0; i < samples; ++i)
+    {
+      reference[i] = noise.At({xs[i], ys[i], zs[i]});
+      sum += reference[i];
+    }
+    JsonLine("noise").Add("path", "at").Rate(samples, Seconds(start)).Add("checksum", sum);
+
+    for (PerlinNoise::Path path : {PerlinNoise::Path::Scalar, PerlinNoise::Path::SSE41, PerlinNoise::Path::AVX2})
+    {
+      if (path > PerlinNoise::BestPath())
+        break;
+      start = Clock::now();
+      noise.AtBatch(xs, ys, zs, out, path);
+      const double seconds = Seconds(start);
+      sum = 0.0;
+      size_t differing = 0;
+      for (size_t i = 0; i < samples; ++i)
+      {
+        sum += out[i];
+        differing += std::memcmp(&out[i], &reference[i], sizeof(float)) != 0 ? 1 : 0;
+      }
+      JsonLine("noise").Add("path", PathName(path)).Rate(samples, seconds).Add("checksum", sum).Add("differing", static_cast<double>(differing));
+    }
+  }
+
+  // Column heights the way Chunk::Generate computed them before the
+  // heightmap: noise for the column and again for its left and front
+  // neighbours. Counts its noise evaluations.
+  void LegacyHeightmap(const PerlinNoise &noise, int worldX, int worldZ, Chunk_t::FlattenData_t &blocks, size_t &evaluations)
+  {
+    const size_t height = chunkSize;
+    const float x0 = static_cast<float>(worldX), z0 = static_cast<float>(worldZ);
+    for (size_t x = 0; x < chunkSize; ++x)
+    {
+      for (size_t z = 0; z < chunkSize; ++z)
+      {
+        size_t maxHeight = static_cast<size_t>(noise.At(glm::vec3(x0 + x, z0 + z, 0) * 0.1f) * height);
+        ++evaluations;
+        if (x > 0)
+        {
+          maxHeight = std::min(maxHeight, static_cast<size_t>(noise.At(glm::vec3(x0 + x - 1, z0 + z, 0) * 0.1f) * height + 1));
+          ++evaluations;
+        }
+        if (z > 0)
+        {
+          maxHeight = std::min(maxHeight, static_cast<size_t>(noise.At(glm::vec3(x0 + x, z0 + z - 1, 0) * 0.1f) * height + 1));
+          ++evaluations;
+        }
+        for (size_t y = 0; y < height; ++y)
+          blocks[(y * chunkSize + x) * chunkSize + z] = y > maxHeight ? Cube::Type::None : y == maxHeight ? Cube::Type::Grass : Cube::Type::Stone;
+      }
+    }
+  }
+
+  // HeightmapGenerator against the per-column path it replaced, on the
+  // same chunks; their blocks must match exactly
+  void BenchHeightmap(int side)
+  {
+    const PerlinNoise noise(seed);
+    const HeightmapGenerator generator(seed);
+    std::vector<Chunk_t::FlattenData_t> legacy(side * side), current(side * side);
+    size_t evaluations = 0;
+    auto start = Clock::now();
+    for (int i = 0; i < side * side; ++i)
+      LegacyHeightmap(noise, (i % side - side / 2) * static_cast<int>(chunkSize), (i / side - side / 2) * static_cast<int>(chunkSize), legacy[i], evaluations);
+    JsonLine("heightmap").Add("path", "per_column").Rate(legacy.size(), Seconds(start)).Add("noise_per_chunk", static_cast<double>(evaluations) / legacy.size());
+
+    start = Clock::now();
+    for (int i = 0; i < side * side; ++i)
+      generator.Generate(glm::ivec3(chunkSize), (i % side - side / 2) * static_cast<int>(chunkSize), (i / side - side / 2) * static_cast<int>(chunkSize), current[i]);
+    JsonLine("heightmap").Add("path", "heightmap").Rate(current.size(), Seconds(start)).Add("noise_per_chunk", static_cast<double>(chunkSize * chunkSize))
+        .Add("identical", legacy == current ? "yes" : "no");
+  }
+
+  // Cost per chunk of each generator and of the FractalGenerator settings
+  // that decide it: the density lattice step (1 samples every block) and
+  // caves, which keep cells below the surface from being skipped as solid
+  void BenchTerrain(int side)
+  {
+    struct Variant
+    {
+      const char *m_name;
+      std::unique_ptr<TerrainGenerator> m_generator;
+    };
+    std::vector<Variant> variants;
+    variants.push_back({"heightmap", std::make_unique<HeightmapGenerator>(seed)});
+    for (int step : {4, 2, 1})
+    {
+      TerrainSettings settings;
+      settings.m_latticeStep = step;
+      variants.push_back({step == 4 ? "fractal_step_4" : step == 2 ? "fractal_step_2" : "fractal_step_1", std::make_unique<FractalGenerator>(settings, seed)});
+    }
+    TerrainSettings noCaves;
+    noCaves.m_caveWidth = 0.0f;
+    variants.push_back({"fractal_no_caves", std::make_unique<FractalGenerator>(noCaves, seed)});
+
+    Chunk_t::FlattenData_t blocks;
+    for (const Variant &variant : variants)
+    {
+      size_t solid = 0;
+      const auto start = Clock::now();
+      for (int i = 0; i < side * side; ++i)
+      {
+        variant.m_generator->Generate(glm::ivec3(chunkSize), (i % side - side / 2) * static_cast<int>(chunkSize), (i / side - side / 2) * static_cast<int>(chunkSize), blocks);
+        solid += std::count_if(blocks.begin(), blocks.end(), [](Cube::Type type)
+                               { return type != Cube::Type::None; });
+      }
+      const double seconds = Seconds(start);
+      JsonLine("terrain").Add("generator", variant.m_name).Rate(side * side, seconds).Add("us_per_chunk", seconds * 1e6 / (side * side)).Add("solid_blocks", static_cast<double>(solid));
+    }
+  }
+
+  // side x side chunks around the origin, generated once and shared by the
+  // single-chunk benchmarks below
+  std::vector<Chunk_t::FlattenData_t> BenchGenerate(const TerrainGenerator &generator, int side)
+  {
+    std::vector<Chunk_t::FlattenData_t> chunks(side * side);
+    const auto start = Clock::now();
+    for (int z = 0; z < side; ++z)
+    {
+      for (int x = 0; x < side; ++x)
+      {
+        generator.Generate(glm::ivec3(chunkSize), (x - side / 2) * static_cast<int>(chunkSize),
+                           (z - side / 2) * static_cast<int>(chunkSize), chunks[z * side + x]);
+      }
+    }
+    const double seconds = Seconds(start);
+
+    size_t solid = 0;
+    for (const auto &blocks : chunks)
+    {
+      for (Cube::Type type : blocks)
+        solid += type != Cube::Type::None ? 1 : 0;
+    }
+    JsonLine("generate").Add("threads", 1.0).Rate(chunks.size(), seconds).Add("solid_blocks", static_cast<double>(solid));
+    return chunks;
+  }
+
+  // Block layouts and loop orders side by side, counting solid blocks: the
+  // 8 byte struct per block chunks used to hold (type and visibility flag),
+  // one byte per block and the palette storage. "linear" follows the y-major
+  // layout, "strided" walks x, then z, then y the way the old loops did.
+  void BenchLayout(const std::vector<Chunk_t::FlattenData_t> &data)
+  {
+    struct LegacyCube
+    {
+      Cube::Type m_type;
+      bool m_isVisible;
+      int32_t m_padding; // Cube::Type was int sized
+    };
+    std::vector<LegacyCube> legacy;
+    std::vector<Chunk_t::Storage_t> storages(data.size());
+    for (size_t c = 0; c < data.size(); ++c)
+    {
+      for (Cube::Type type : data[c])
+        legacy.push_back({type, type != Cube::Type::None, 0});
+      storages[c].Assign(data[c]);
+    }
+    size_t storageBytes = 0;
+    for (const auto &storage : storages)
+      storageBytes += storage.MemoryUsage();
+
+    constexpr size_t volume = chunkSize * chunkSize * chunkSize;
+    const auto count = [&](const char *layout, size_t bytes, auto &&solidAt)
+    {
+      for (bool strided : {false, true})
+      {
+        size_t solid = 0;
+        const auto start = Clock::now();
+        for (size_t c = 0; c < data.size(); ++c)
+        {
+          if (!strided)
+          {
+            for (size_t i = 0; i < volume; ++i)
+              solid += solidAt(c, i);
+            continue;
+          }
+          for (size_t x = 0; x < chunkSize; ++x)
+            for (size_t z = 0; z < chunkSize; ++z)
+              for (size_t y = 0; y < chunkSize; ++y)
+                solid += solidAt(c, (y * chunkSize + x) * chunkSize + z);
+        }
+        JsonLine("iterate").Add("layout", layout).Add("order", strided ? "strided" : "linear").Rate(data.size() * volume, Seconds(start))
+            .Add("bytes", static_cast<double>(bytes)).Add("solid", static_cast<double>(solid));
+      }
+    };
+    count("legacy", legacy.size() * sizeof(LegacyCube), [&](size_t c, size_t i)
+          { return legacy[c * volume + i].m_isVisible ? 1 : 0; });
+    count("flat", data.size() * sizeof(Chunk_t::FlattenData_t), [&](size_t c, size_t i)
+          { return data[c][i] != Cube::Type::None ? 1 : 0; });
+    count("storage", storageBytes, [&](size_t c, size_t i)
+          { return storages[c].Get(i) != Cube::Type::None ? 1 : 0; });
+  }
+
+  // The same meshing work split by ParallelFor over 0 (the caller alone)
+  // to maxThreads workers; speedup is against the caller alone
+  void BenchParallel(const std::vector<std::unique_ptr<Chunk_t>> &chunks, size_t maxThreads)
+  {
+    double single = 0.0;
+    for (size_t threads = 0;; threads = std::min(std::max<size_t>(threads * 2, 1), maxThreads))
+    {
+      JobSystem jobs(threads);
+      std::atomic<size_t> triangles{0};
+      const auto start = Clock::now();
+      jobs.ParallelFor(chunks.size(), [&](size_t i)
+                       { triangles.fetch_add(chunks[i]->BuildMesh().m_indices.size() / 3, std::memory_order_relaxed); });
+      const double seconds = Seconds(start);
+      if (threads == 0)
+        single = seconds;
+      JsonLine("parallel_for").Add("threads", static_cast<double>(threads)).Rate(chunks.size(), seconds).Add("speedup", single / seconds).Add("triangles", static_cast<double>(triangles.load()));
+      if (threads == maxThreads)
+        break;
+    }
+  }
+
+  // Standalone chunks without neighbours, so borders count as open air
+  void BenchChunks(const std::vector<Chunk_t::FlattenData_t> &data, size_t maxThreads)
+  {
+    std::vector<std::unique_ptr<Chunk_t>> chunks;
+    for (size_t i = 0; i < data.size(); ++i)
+      chunks.push_back(std::make_unique<Chunk_t>(glm::vec2(static_cast<float>(i * chunkSize), 0.0f)));
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < data.size(); ++i)
+      chunks[i]->Assign(data[i]);
+    JsonLine("assign").Rate(chunks.size(), Seconds(start));
+
+    start = Clock::now();
+    for (auto &chunk : chunks)
+      chunk->Update();
+    JsonLine("visibility").Rate(chunks.size(), Seconds(start));
+
+    size_t triangles = 0;
+    start = Clock::now();
+    for (auto &chunk : chunks)
+      triangles += chunk->AssembleMesh().m_indices.size() / 3;
+    JsonLine("mesh_assemble").Rate(chunks.size(), Seconds(start)).Add("triangles", static_cast<double>(triangles));
+
+    triangles = 0;
+    start = Clock::now();
+    for (auto &chunk : chunks)
+      triangles += chunk->BuildMesh().m_indices.size() / 3;
+    JsonLine("mesh_build").Rate(chunks.size(), Seconds(start)).Add("triangles", static_cast<double>(triangles));
+
+    for (int level = 1; level < Chunk_t::s_lodLevels; ++level)
+    {
+      triangles = 0;
+      start = Clock::now();
+      for (auto &chunk : chunks)
+        triangles += chunk->BuildLodMesh(level).m_indices.size() / 3;
+      JsonLine("mesh_lod").Add("level", level).Rate(chunks.size(), Seconds(start)).Add("triangles", static_cast<double>(triangles));
+    }
+
+    size_t bytes = 0;
+    for (const auto &chunk : chunks)
+      bytes += chunk->Blocks().MemoryUsage();
+    JsonLine("memory").Add("chunks", static_cast<double>(chunks.size())).Add("flat_bytes", static_cast<double>(chunks.size() * sizeof(Chunk_t::FlattenData_t))).Add("storage_bytes", static_cast<double>(bytes));
+
+    // Każdy blok usunięty pojedynczo: sekcje muszą wrócić do jednej wartości
+    bytes = 0;
+    size_t uniform = 0;
+    Chunk_t::Storage_t storage;
+    start = Clock::now();
+    for (const auto &blocks : data)
+    {
+      storage.Assign(blocks);
+      for (size_t i = 0; i < blocks.size(); ++i)
+        storage.Set(i, Cube::Type::None);
+      bytes += storage.MemoryUsage();
+      uniform += storage.UniformSectionCount();
+    }
+    JsonLine("memory_cleared").Rate(data.size() * Chunk_t::Storage_t::s_size, Seconds(start)).Add("storage_bytes", static_cast<double>(bytes))
+        .Add("uniform_sections", static_cast<double>(uniform)).Add("sections", static_cast<double>(data.size() * Chunk_t::Storage_t::s_sectionCount));
+
+    BenchLayout(data);
+    BenchParallel(chunks, maxThreads);
+  }
+
+  // Region files in the system's temporary directory: every chunk saved in
+  // one batch, read back through a fresh mapping, and single chunks saved
+  // one call each the way edits trickle in. Each of those rewrites and
+  // syncs its whole region.
+  void BenchRegions(const std::vector<Chunk_t::FlattenData_t> &data)
+  {
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "voxel_bench_regions";
+    std::filesystem::remove_all(directory);
+    const int side = static_cast<int>(std::sqrt(static_cast<double>(data.size())));
+    const auto coordsOf = [side](size_t i)
+    { return glm::ivec2(static_cast<int>(i) % side - side / 2, static_cast<int>(i) / side - side / 2); };
+
+    std::vector<RegionStore::StoredChunk> chunks;
+    for (size_t i = 0; i < data.size(); ++i)
+      chunks.push_back({coordsOf(i), data[i]});
+    {
+      RegionStore store(directory, glm::ivec3(chunkSize));
+      const auto start = Clock::now();
+      const bool saved = store.Save(chunks);
+      const double seconds = Seconds(start);
+      size_t bytes = 0;
+      for (const auto &entry : std::filesystem::directory_iterator(directory))
+        bytes += entry.file_size();
+      JsonLine("region_save").Add("batch", static_cast<double>(chunks.size())).Rate(chunks.size(), seconds).Add("file_bytes", static_cast<double>(bytes))
+          .Add("raw_bytes", static_cast<double>(data.size() * sizeof(Chunk_t::FlattenData_t))).Add("ok", saved ? "yes" : "no");
+    }
+
+    {
+      RegionStore store(directory, glm::ivec3(chunkSize));
+      Chunk_t::FlattenData_t blocks;
+      size_t matching = 0;
+      const auto start = Clock::now();
+      for (size_t i = 0; i < data.size(); ++i)
+        matching += store.Load(coordsOf(i), blocks) && blocks == data[i] ? 1 : 0;
+      JsonLine("region_load").Rate(data.size(), Seconds(start)).Add("matching", static_cast<double>(matching));
+    }
+
+    {
+      RegionStore store(directory, glm::ivec3(chunkSize));
+      const size_t count = std::min<size_t>(32, chunks.size());
+      const auto start = Clock::now();
+      for (size_t i = 0; i < count; ++i)
+        store.Save(std::span<const RegionStore::StoredChunk>(&chunks[i], 1));
+      JsonLine("region_save").Add("batch", 1.0).Rate(count, Seconds(start));
+    }
+    std::filesystem::remove_all(directory);
+  }
+
+  std::unique_ptr<World_t> BenchWorld(int radius, size_t threads)
+  {
+    auto world = std::make_unique<World_t>(radius, 4096, threads, std::make_unique<FractalGenerator>(TerrainSettings(), seed));
+    const auto start = Clock::now();
+    world->updateVisibleChunks(glm::vec3(8.0f, 12.0f, 8.0f));
+    world->Flush();
+    JsonLine("world_load").Add("threads", static_cast<double>(threads)).Add("radius", radius).Rate(world->ChunkCount(), Seconds(start));
+    return world;
+  }
+
+  void BenchRaycast(World_t &world, int radius, size_t threads)
+  {
+    const size_t count = 1 << 16;
+    const float spread = radius * static_cast<float>(chunkSize);
+    Random random(seed, 2);
+    std::vector<Ray> rays;
+    rays.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+      const glm::vec3 origin((random.NextFloat() * 2.0f - 1.0f) * spread, 12.0f + random.NextFloat() * 4.0f, (random.NextFloat() * 2.0f - 1.0f) * spread);
+      // Kierunek równomiernie na sferze
+      const float y = random.NextFloat() * 2.0f - 1.0f;
+      const float angle = random.NextFloat() * 6.2831853f;
+      const float r = std::sqrt(1.0f - y * y);
+      rays.emplace_back(origin, glm::vec3(r * std::cos(angle), y, r * std::sin(angle)));
+    }
+
+    const Ray::time_t maxDistance = 64.0f;
+    std::vector<World_t::RaycastHit> hits(count);
+    size_t found = 0;
+    auto start = Clock::now();
+    for (size_t i = 0; i < count; ++i)
+      found += world.Raycast(rays[i], maxDistance, hits[i]) ? 1 : 0;
+    JsonLine("raycast").Add("threads", 1.0).Rate(count, Seconds(start)).Add("hits", static_cast<double>(found));
+
+    start = Clock::now();
+    found = world.Raycast(rays, maxDistance, hits);
+    JsonLine("raycast").Add("threads", static_cast<double>(threads)).Rate(count, Seconds(start)).Add("hits", static_cast<double>(found));
+  }
+
+  // Chunk::Hit against the path it replaced: an AABB test for every solid
+  // block of the chunk, keeping the nearest. Rays start anywhere in or
+  // above a chunk near the origin; agreeing counts rays where both find
+  // the same block or both miss.
+  void BenchChunkRaycast(World_t &world)
+  {
+    const size_t count = 2048;
+    const Ray::time_t maxDistance = 64.0f;
+    Random random(seed, 5);
+    struct Case
+    {
+      const Chunk_t *m_chunk;
+      Ray m_ray;
+    };
+    std::vector<Case> cases;
+    while (cases.size() < count)
+    {
+      const glm::ivec2 coords(static_cast<int>(random.Below(4)) - 2, static_cast<int>(random.Below(4)) - 2);
+      const Chunk_t *chunk = world.ChunkAt(coords);
+      const glm::vec3 origin = glm::vec3(coords.x, 0, coords.y) * static_cast<float>(chunkSize) +
+                               glm::vec3(random.NextFloat(), random.NextFloat() * 1.25f, random.NextFloat()) * static_cast<float>(chunkSize);
+      const float y = random.NextFloat() * 2.0f - 1.0f;
+      const float angle = random.NextFloat() * 6.2831853f;
+      const float r = std::sqrt(1.0f - y * y);
+      if (chunk)
+        cases.push_back({chunk, Ray(origin, glm::vec3(r * std::cos(angle), y, r * std::sin(angle)))});
+    }
+
+    std::vector<glm::ivec3> dda(count, glm::ivec3(-1)), perCube(count, glm::ivec3(-1));
+    auto start = Clock::now();
+    for (size_t i = 0; i < count; ++i)
+    {
+      Chunk_t::HitRecord record;
+      if (cases[i].m_chunk->Hit(cases[i].m_ray, 0.0f, maxDistance, record) == Ray::HitType::Hit)
+        dda[i] = record.m_cubeIndex;
+    }
+    JsonLine("raycast_chunk").Add("path", "dda").Rate(count, Seconds(start));
+
+    start = Clock::now();
+    for (size_t i = 0; i < count; ++i)
+    {
+      const Chunk_t &chunk = *cases[i].m_chunk;
+      const glm::vec3 origin = chunk.Bounds().Min();
+      Ray::time_t nearest = maxDistance;
+      for (int y = 0; y < static_cast<int>(chunkSize); ++y)
+        for (int x = 0; x < static_cast<int>(chunkSize); ++x)
+          for (int z = 0; z < static_cast<int>(chunkSize); ++z)
+          {
+            if (chunk.BlockAt(x, y, z) == Cube::Type::None)
+              continue;
+            AABB::HitRecord record;
+            const AABB box(origin + glm::vec3(x, y, z), origin + glm::vec3(x + 1, y + 1, z + 1));
+            if (box.Hit(cases[i].m_ray, 0.0f, nearest, record) == Ray::HitType::Hit && record.m_time < nearest)
+            {
+              nearest = record.m_time;
+              perCube[i] = glm::ivec3(x, y, z);
+            }
+          }
+    }
+    const double seconds = Seconds(start);
+    size_t agreeing = 0;
+    for (size_t i = 0; i < count; ++i)
+      agreeing += dda[i] == perCube[i] ? 1 : 0;
+    JsonLine("raycast_chunk").Add("path", "per_cube").Rate(count, seconds).Add("agreeing", static_cast<double>(agreeing));
+  }
+
+  // Chunk::Hit, which crosses empty bricks (and empty regions, in chunks of
+  // more than one region) in a single step through the occupancy pyramid,
+  // against stepping VoxelRay through every cell and looking at the block.
+  // The world's chunks are one region, so a second shape four times as tall
+  // has empty regions to skip. Rays come from outside the chunk and aim at a
+  // random point in it; the fills range from no blocks to almost all solid.
+  template <typename ChunkT>
+  void BenchOccupancy(const TerrainGenerator &generator, const char *shape)
+  {
+    const size_t count = 4096;
+    const Ray::time_t maxDistance = 256.0f;
+    Random random(seed, 6);
+    struct Fill
+    {
+      const char *m_name;
+      float m_solid; // Chance of a block, below 0 for a generated terrain chunk
+    };
+    for (const Fill &fill : {Fill{"empty", 0.0f}, Fill{"mostly_air", 0.02f}, Fill{"terrain", -1.0f}, Fill{"mostly_solid", 0.95f}})
+    {
+      ChunkT chunk{glm::vec2(0.0f)};
+      const glm::vec3 size = chunk.Bounds().Max() - chunk.Bounds().Min();
+      auto blocks = std::make_unique<typename ChunkT::FlattenData_t>();
+      if (fill.m_solid >= 0.0f)
+      {
+        for (Cube::Type &block : *blocks)
+          block = random.NextFloat() < fill.m_solid ? Cube::Type::Stone : Cube::Type::None;
+      }
+      else
+        generator.Generate(glm::ivec3(size), 0, 0, *blocks);
+
+      auto start = Clock::now();
+      chunk.Assign(*blocks);
+      chunk.Update();
+      const double update = Seconds(start);
+
+      std::vector<Ray> rays;
+      while (rays.size() < count)
+      {
+        const float y = random.NextFloat() * 2.0f - 1.0f;
+        const float angle = random.NextFloat() * 6.2831853f;
+        const float r = std::sqrt(1.0f - y * y);
+        const glm::vec3 origin = size * 0.5f + glm::vec3(r * std::cos(angle), y, r * std::sin(angle)) * glm::length(size);
+        const glm::vec3 target = glm::vec3(random.NextFloat(), random.NextFloat(), random.NextFloat()) * size;
+        rays.emplace_back(origin, glm::normalize(target - origin));
+      }
+
+      // Both paths hand back the whole record, so the walk does the same work
+      const typename ChunkT::HitRecord none{glm::ivec3(-1), glm::ivec3(-1), Cube::Face::Top, 0.0f};
+      std::vector<typename ChunkT::HitRecord> skipping(count, none), walking(count, none);
+      const auto skip = [&]
+      {
+        for (size_t i = 0; i < count; ++i)
+        {
+          chunk.Hit(rays[i], 0.0f, maxDistance, skipping[i]);
+        }
+      };
+      const auto walkAll = [&]
+      {
+        for (size_t i = 0; i < count; ++i)
+        {
+          Ray::time_t min = 0.0f, max = maxDistance;
+          if (!chunk.Bounds().Clip(rays[i], min, max))
+            continue;
+          VoxelRay walk(rays[i], min, max, glm::ivec3(0), glm::ivec3(size) - 1);
+          do
+          {
+            const glm::ivec3 cell = walk.Cell();
+            if (chunk.BlockAt(cell.x, cell.y, cell.z) != Cube::Type::None)
+            {
+              walking[i] = {cell, cell + FaceNormal(walk.EnteredFace()), walk.EnteredFace(), walk.Time()};
+              break;
+            }
+          } while (walk.Step());
+        }
+      };
+      // Best of a few alternating rounds, so neither path pays for a cold cache
+      double skipped = 1e9, walked = 1e9;
+      for (int round = 0; round < 40; ++round)
+      {
+        start = Clock::now();
+        skip();
+        skipped = std::min(skipped, Seconds(start));
+        start = Clock::now();
+        walkAll();
+        walked = std::min(walked, Seconds(start));
+      }
+
+      size_t agreeing = 0, hits = 0;
+      for (size_t i = 0; i < count; ++i)
+      {
+        const typename ChunkT::HitRecord &a = skipping[i], &b = walking[i];
+        // Skipping reaches the hit time in fewer additions, so it may differ in the last bits
+        agreeing += a.m_cubeIndex == b.m_cubeIndex && a.m_face == b.m_face && std::abs(a.m_time - b.m_time) <= 1e-3f ? 1 : 0;
+        hits += a.m_cubeIndex != glm::ivec3(-1) ? 1 : 0;
+      }
+      JsonLine("occupancy").Add("shape", shape).Add("fill", fill.m_name).Add("path", "voxel_walk").Rate(count, walked);
+      JsonLine("occupancy").Add("shape", shape).Add("fill", fill.m_name).Add("path", "skipping").Rate(count, skipped).Add("hits", static_cast<double>(hits))
+          .Add("agreeing", static_cast<double>(agreeing)).Add("update_us", update * 1e6);
+    }
+  }
+
+  // Place or remove a random block, then bring the edited chunk back up to
+  // date the way a frame would: Update and the patched mesh. Each step is
+  // timed on its own, in microseconds per edit.
+  void BenchEdit(World_t &world, int radius)
+  {
+    const size_t count = 4096;
+    const int spread = radius * static_cast<int>(chunkSize);
+    Random random(seed, 3);
+    size_t edits = 0;
+    double editing = 0.0, updating = 0.0, assembling = 0.0;
+    size_t triangles = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+      const glm::ivec3 block(static_cast<int>(random.Below(2 * spread)) - spread, random.Below(chunkSize),
+                             static_cast<int>(random.Below(2 * spread)) - spread);
+      glm::ivec3 local;
+      Chunk_t *chunk = world.ChunkAt(block, local);
+      if (!chunk)
+        continue;
+      auto start = Clock::now();
+      const bool changed = chunk->BlockAt(local.x, local.y, local.z) == Cube::Type::None
+                               ? chunk->PlaceBlock(local.x, local.y, local.z, Cube::Type::Stone)
+                               : chunk->RemoveBlock(local.x, local.y, local.z);
+      editing += Seconds(start);
+      if (!changed)
+        continue;
+      start = Clock::now();
+      chunk->Update();
+      updating += Seconds(start);
+      start = Clock::now();
+      triangles += chunk->AssembleMesh().m_indices.size() / 3;
+      assembling += Seconds(start);
+      ++edits;
+    }
+    const double scale = edits ? 1e6 / edits : 0.0;
+    JsonLine("edit").Rate(edits, editing + updating + assembling).Add("edit_us", editing * scale).Add("update_us", updating * scale)
+        .Add("assemble_us", assembling * scale).Add("triangles_per_chunk", edits ? static_cast<double>(triangles) / edits : 0.0);
+    // Sąsiedzi zmienionych krawędzi, poza pomiarem
+    world.Flush();
+  }
+
+  void BenchCull(World_t &world)
+  {
+    const int poses = 256;
+    const glm::mat4 projection = glm::perspective(glm::radians(70.0f), 4.0f / 3.0f, 0.1f, 1000.0f);
+    // Na wysokości oczu gracza stojącego na terenie
+    glm::vec3 position(8.0f, 2.0f, 8.0f);
+    glm::ivec3 local;
+    for (int y = chunkSize - 1; y >= 0; --y)
+    {
+      const Chunk_t *chunk = world.ChunkAt(glm::ivec3(8, y, 8), local);
+      if (chunk && chunk->BlockAt(local.x, local.y, local.z) != Cube::Type::None)
+      {
+        position.y = y + 2.6f;
+        break;
+      }
+    }
+    for (bool occlusion : {false, true})
+    {
+      world.SetOcclusionCulling(occlusion);
+      size_t visible = 0;
+      const auto start = Clock::now();
+      for (int i = 0; i < poses; ++i)
+      {
+        const float yaw = i * 6.2831853f / poses;
+        const glm::vec3 front(std::cos(yaw), 0.0f, std::sin(yaw));
+        visible += world.Cull(projection * glm::lookAt(position, position + front, glm::vec3(0.0f, 1.0f, 0.0f)));
+      }
+      const double seconds = Seconds(start);
+      JsonLine("cull").Add("occlusion", occlusion ? "on" : "off").Add("chunks", static_cast<double>(world.ChunkCount())).Rate(poses, seconds).Add("visible_per_pose", static_cast<double>(visible) / poses);
+    }
+  }
+
+  // The camera flies out in a straight line far faster than a player walks
+  // and comes back, editing a random block near it every frame; the times
+  // are of whole main thread frames without drawing. With a save directory
+  // edited chunks are written as they unload on the way out and read back
+  // on the way home, so the worst frames show any wait on ChunkIO.
+  void BenchStreaming(int radius, size_t threads)
+  {
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "voxel_bench_saves";
+    const int frames = 256;
+    const float speed = 4.0f; // Bloków na klatkę: 240 na sekundę przy 60 FPS
+    const int spread = radius * static_cast<int>(chunkSize);
+    const glm::mat4 projection = glm::perspective(glm::radians(70.0f), 4.0f / 3.0f, 0.1f, 1000.0f);
+    for (bool saving : {false, true})
+    {
+      std::filesystem::remove_all(directory);
+      World_t world(radius, 4096, threads, std::make_unique<FractalGenerator>(TerrainSettings(), seed));
+      if (saving)
+        world.SetSaveDirectory(directory);
+      world.updateVisibleChunks(glm::vec3(8.0f, 14.0f, 8.0f));
+      world.Flush();
+
+      Random random(seed, 4);
+      for (bool out : {true, false})
+      {
+        const glm::vec3 heading(out ? 1.0f : -1.0f, 0.0f, 0.0f);
+        std::vector<double> times;
+        for (int frame = 1; frame <= frames; ++frame)
+        {
+          const glm::vec3 position(8.0f + speed * (out ? frame : frames - frame), 14.0f, 8.0f);
+          const auto start = Clock::now();
+          world.updateVisibleChunks(position, heading);
+          const glm::ivec3 block(static_cast<int>(position.x) + static_cast<int>(random.Below(2 * spread)) - spread, random.Below(chunkSize),
+                                 static_cast<int>(random.Below(2 * spread)) - spread);
+          glm::ivec3 local;
+          if (Chunk_t *chunk = world.ChunkAt(block, local))
+          {
+            if (chunk->BlockAt(local.x, local.y, local.z) == Cube::Type::None)
+              chunk->PlaceBlock(local.x, local.y, local.z, Cube::Type::Stone);
+            else
+              chunk->RemoveBlock(local.x, local.y, local.z);
+          }
+          world.Cull(projection * glm::lookAt(position, position + heading, glm::vec3(0.0f, 1.0f, 0.0f)));
+          times.push_back(Seconds(start) * 1e3);
+        }
+
+        double total = 0.0;
+        for (double time : times)
+          total += time;
+        std::sort(times.begin(), times.end());
+        JsonLine("stream").Add("io", saving ? "disk" : "none").Add("way", out ? "out" : "back").Add("threads", static_cast<double>(threads)).Add("frames", frames)
+            .Add("mean_ms", total / frames).Add("p99_ms", times[frames * 99 / 100]).Add("max_ms", times.back());
+      }
+    }
+    std::filesystem::remove_all(directory);
+  }
+}
+
+// bench [max threads] [load radius] [trace file]; with a trace file the
+// profiler is on and its zones count in the timings
+int main(int argc, char *argv[])
+{
+  const size_t maxThreads = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : JobSystem::DefaultThreadCount();
+  const int radius = argc > 2 ? std::atoi(argv[2]) : 6;
+  if (maxThreads == 0 || radius <= 0)
+  {
+    std::cerr << "Usage: bench [max threads] [load radius] [trace file]" << std::endl;
+    return 1;
+  }
+  Profiler::SetThreadName("Main");
+  Profiler::SetEnabled(argc > 3);
+  JsonLine("config").Add("seed", static_cast<double>(seed)).Add("chunk_size", static_cast<double>(chunkSize)).Add("max_threads", static_cast<double>(maxThreads)).Add("radius", radius);
+
+  BenchNoise();
+  BenchHeightmap(16);
+  BenchTerrain(16);
+  const FractalGenerator generator(TerrainSettings(), seed);
+  const std::vector<Chunk_t::FlattenData_t> data = BenchGenerate(generator, 16);
+  BenchChunks(data, maxThreads);
+  BenchRegions(data);
+
+  std::unique_ptr<World_t> world;
+  for (size_t threads = 1;; threads = std::min(threads * 2, maxThreads))
+  {
+    world.reset();
+    world = BenchWorld(radius, threads);
+    if (threads == maxThreads)
+      break;
+  }
+
+  BenchRaycast(*world, radius, maxThreads);
+  BenchChunkRaycast(*world);
+  BenchOccupancy<Chunk_t>(generator, "cube");
+  BenchOccupancy<Chunk<chunkSize, chunkSize, chunkSize * 4>>(generator, "tall");
+  BenchEdit(*world, radius);
+  BenchCull(*world);
+  world.reset();
+  BenchStreaming(radius, maxThreads);
+  if (argc > 3 && !Profiler::WriteTrace(argv[3]))
+    return 1;
+  return 0;
+}
+// g++ -O2 -o bench bench.cpp Cube.cpp CubeInstances.cpp PerlinNoise.cpp TerrainGenerator.cpp RegionFile.cpp ChunkIO.cpp JobSystem.cpp AABB.cpp Frustum.cpp OcclusionBuffer.cpp Ray.cpp Profiler.cpp -I/usr/include/glm -std=c++20 -pthread
@@ -1,6 +1,10 @@
 #include "../include/Camera.hpp"
+#include "../include/CameraBuffer.hpp"
 #include "../include/Chunk.hpp"
+#include "../include/GpuTimer.hpp"
+#include "../include/Profiler.hpp"
 #include "../include/World.hpp"
+#include "../include/WorldRenderer.hpp"
 #include <SFML/Window.hpp>
 #include <SFML/Window/Context.hpp>
 #include <SFML/Window/ContextSettings.hpp>
@@ -12,6 +16,7 @@
 
 int main()
 {
+  Profiler::SetThreadName("Main");
   sf::ContextSettings contextSettings;
   contextSettings.depthBits = 24;
   contextSettings.stencilBits = 8;
@@ -37,15 +42,17 @@ int main()
   Camera camera(glm::vec3(16.0f, 16.0f, 16.0f), glm::vec3(0.0f, 0.0f, -1.0f), -90.0f, 0.0f);
 
   ShaderProgram shaders;
+  ShaderProgram instancedShaders(ShaderProgram::Variant::Instanced);
   GLuint programId = shaders.getProgramId();
-  if (programId == 0)
+  if (programId == 0 || instancedShaders.getProgramId() == 0)
   {
     std::cerr << "Failed to create shader program" << std::endl;
     return -1;
   }
 
-  shaders.use();
-  shaders.setUniform("projection", camera.Projection());
+  // view/projection wspólne dla obu programów
+  CameraBuffer cameraBuffer;
+  cameraBuffer.Update(camera.View(), camera.Projection());
 
   sf::Vector2i windowCenter(window.getSize().x / 2, window.getSize().y / 2);
   sf::Vector2i mousePosition = sf::Mouse::getPosition();
@@ -53,10 +60,23 @@ int main()
   glEnable(GL_DEPTH_TEST);
 
   const size_t chunkSize = 16; // przykładowy rozmiar chunków
-  World<chunkSize, 5> world;
+  const uint64_t seed = 1337; // ten sam seed, ten sam świat
+  // promień ładowania w chunkach, limit chunków, wątki, teren
+  World<chunkSize> world(3, 64, JobSystem::DefaultThreadCount(), std::make_unique<FractalGenerator>(TerrainSettings(), seed));
+  std::cout << "Seed: " << world.Seed() << std::endl;
+  world.SetSaveDirectory("../saves/" + std::to_string(seed));
+  world.updateVisibleChunks(camera.m_position, camera.m_front);
+  world.Flush();
+  world.PrintMemoryReport(std::cout);
+  // Paleta, siatki i LOD na GPU; świat sam w sobie nie potrzebuje GL
+  WorldRenderer<chunkSize> renderer;
   // RayTracing dla niszczenia i tworzenia bloków
-  Ray::HitType hitType;
-  Chunk<chunkSize, chunkSize, chunkSize>::HitRecord hitRecord;
+  World<chunkSize>::RaycastHit hit;
+  // I przełącza między siatką chunków a instancjonowanymi sześcianami
+  RenderMode renderMode = RenderMode::Meshed;
+  // F3 włącza profiler (podsumowanie co 2 s), F4 zapisuje ślad dla chrome://tracing
+  GpuTimer gpuTimer;
+  float summaryTimer = 0.0f;
 
   // Clock start
   sf::Clock clock;
@@ -64,13 +84,21 @@ int main()
   while (window.isOpen())
   {
     const float dt = clock.restart().asSeconds();
+    Profiler::BeginFrame();
+    gpuTimer.Collect();
+    if (Profiler::Enabled() && (summaryTimer += dt) >= 2.0f)
+    {
+      summaryTimer = 0.0f;
+      Profiler::PrintSummary(std::cout);
+    }
 
-    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-    world.getChunk(camera.m_position);
-    auto chunk = world.m_chunk;
+    {
+      GpuTimer::Zone gpuZone(gpuTimer, "Clear");
+      glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
 
+    const uint64_t inputStart = Profiler::Now();
     sf::Event event;
     while (window.pollEvent(event))
     {
@@ -81,33 +109,39 @@ int main()
       else if (event.type == sf::Event::Resized)
       {
         glViewport(0, 0, event.size.width, event.size.height);
+      }
+      else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::I)
+      {
+        renderMode = renderMode == RenderMode::Meshed ? RenderMode::Instanced : RenderMode::Meshed;
+      }
+      else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::O)
+      {
+        world.SetOcclusionCulling(!world.OcclusionCulling());
+        std::cout << "Occlusion culling " << (world.OcclusionCulling() ? "on" : "off") << std::endl;
+      }
+      else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F3)
+      {
+        Profiler::SetEnabled(!Profiler::Enabled());
+        summaryTimer = 0.0f;
+        std::cout << "Profiler " << (Profiler::Enabled() ? "on" : "off") << std::endl;
+      }
+      else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F4)
+      {
+        Profiler::PrintSummary(std::cout);
+        if (Profiler::WriteTrace("trace.json"))
+          std::cout << "Trace written to trace.json" << std::endl;
       } // add and remove blocks
-      else if (event.type == sf::Event::MouseButtonPressed)
+      else if (event.type == sf::Event::MouseButtonPressed &&
+               world.Raycast(Ray(camera.m_position, camera.m_front), 10.0f, hit))
       {
-        // hit
-        hitType = chunk->Hit(Ray(camera.m_position, camera.m_front), 1.0f, 10.0f, hitRecord);
-        if (hitType == Ray::HitType::Hit)
+        if (event.mouseButton.button == sf::Mouse::Left)
+        {
+          hit.m_chunk->RemoveBlock(hit.m_local.x, hit.m_local.y, hit.m_local.z);
+        }
+        else if (event.mouseButton.button == sf::Mouse::Right && hit.m_placementChunk)
         {
-          if (event.mouseButton.button == sf::Mouse::Left)
-          {
-            chunk->RemoveBlock(hitRecord.m_cubeIndex.z, hitRecord.m_cubeIndex.x, hitRecord.m_cubeIndex.y);
-          }
-          else if (event.mouseButton.button == sf::Mouse::Right)
-          {
-
-            auto origin = chunk->getOrigin();
-            glm::vec3 hitCubeCenter = glm::vec3(hitRecord.m_cubeIndex) + glm::vec3(0.5f) + glm::vec3(origin.x, origin.y, 0);
-            glm::vec3 direction = glm::normalize(hitCubeCenter - Ray(camera.m_position, camera.m_front).Origin());
-
-            glm::ivec3 neighborOffset(
-                (direction.x > 0.5f) ? 1 : ((direction.x < -0.5f) ? -1 : 0),
-                (direction.y > 0.5f) ? 1 : ((direction.y < -0.5f) ? -1 : 0),
-                (direction.z > 0.5f) ? 1 : ((direction.z < -0.5f) ? -1 : 0));
-
-            hitRecord.m_neighbourIndex = hitRecord.m_cubeIndex - neighborOffset;
-
-            chunk->PlaceBlock(hitRecord.m_neighbourIndex.z, hitRecord.m_neighbourIndex.x, hitRecord.m_neighbourIndex.y, Cube::Type::Stone);
-          }
+          // Komórka przed trafioną ścianą, także w sąsiednim chunku
+          hit.m_placementChunk->PlaceBlock(hit.m_placementLocal.x, hit.m_placementLocal.y, hit.m_placementLocal.z, Cube::Type::Stone);
         }
       }
     }
@@ -140,16 +174,26 @@ int main()
     const sf::Vector2i newMousePosition = sf::Mouse::getPosition();
     camera.Rotate(newMousePosition - mousePosition);
     mousePosition = newMousePosition;
+    if (Profiler::Enabled())
+      Profiler::Record("Events and input", inputStart, Profiler::Now() - inputStart);
 
-    shaders.setUniform("view", camera.View());
-    shaders.setUniform("projection", camera.Projection());
+    ShaderProgram &activeShaders = renderMode == RenderMode::Instanced ? instancedShaders : shaders;
+    activeShaders.use();
+    cameraBuffer.Update(camera.View(), camera.Projection());
 
-    world.updateVisibleChunks(camera.m_position);
-    world.Draw(shaders);
+    world.updateVisibleChunks(camera.m_position, camera.m_front);
+    // Tylko chunki w polu widzenia kamery; po włączeniu klawiszem O także tylko niezasłonięte terenem
+    world.Cull(camera.Projection() * camera.View());
+    {
+      GpuTimer::Zone gpuZone(gpuTimer, "Draw");
+      renderer.Draw(world, activeShaders, camera.m_position, renderMode);
+    }
 
-    window.display();
+    {
+      PROFILE_ZONE("Display");
+      window.display();
+    }
   }
 
   return 0;
 }
-// g++ -o main main.cpp Camera.cpp Cube.cpp ShaderProgram.cpp PerlinNoise.cpp CubePalette.cpp AABB.cpp Ray.cpp -lGLEW -lGL -lsfml-window -lsfml-graphics -lsfml-system -I/usr/include/glm -std=c++20
\ No newline at end of file
@@ -0,0 +1,261 @@
+#include "../include/AABB.hpp"
+#include "Check.hpp"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// AABB::Hit, Clip and the batch kernels on every path the CPU has, against a
+// slab test written out plainly. Boxes and rays sit on a small grid so rays
+// often start on a face or run along one; some rays have a zero (or -0)
+// direction component and some a NaN, which must miss.
+
+namespace
+{
+  constexpr float s_infinity = std::numeric_limits<float>::infinity();
+  const float s_nan = std::numeric_limits<float>::quiet_NaN();
+
+  std::mt19937 s_random(1337);
+
+  float Uniform(float min, float max)
+  {
+    return std::uniform_real_distribution<float>(min, max)(s_random);
+  }
+
+  bool Chance(float probability)
+  {
+    return Uniform(0.0f, 1.0f) < probability;
+  }
+
+  float Coordinate()
+  {
+    return Chance(0.5f) ? static_cast<float>(std::uniform_int_distribution<int>(-4, 4)(s_random)) : Uniform(-4.0f, 4.0f);
+  }
+
+  float DirectionComponent(bool withNaN)
+  {
+    if (withNaN && Chance(0.1f))
+      return s_nan;
+    if (Chance(0.15f))
+      return Chance(0.5f) ? 0.0f : -0.0f;
+    const float value = Uniform(1e-3f, 1.0f);
+    return Chance(0.5f) ? value : -value;
+  }
+
+  AABB RandomBox()
+  {
+    const glm::vec3 min(Coordinate(), Coordinate(), Coordinate());
+    glm::vec3 size;
+    for (int i = 0; i < 3; ++i)
+      size[i] = Chance(0.1f) ? 0.0f : Chance(0.5f) ? static_cast<float>(std::uniform_int_distribution<int>(1, 3)(s_random)) : Uniform(0.0f, 3.0f);
+    return AABB(min, min + size);
+  }
+
+  Ray RandomRay(bool withNaN)
+  {
+    glm::vec3 origin(Coordinate(), Coordinate(), Coordinate());
+    if (withNaN && Chance(0.05f))
+      origin.y = s_nan;
+    return Ray(origin, glm::vec3(DirectionComponent(withNaN), DirectionComponent(withNaN), DirectionComponent(withNaN)));
+  }
+
+  struct Span
+  {
+    bool m_hit;
+    float m_enter, m_exit;
+  };
+
+  // A ray parallel to a slab is limited by it only when it starts outside
+  Span Reference(const Ray &ray, const AABB &box, float minTime, float maxTime)
+  {
+    const glm::vec3 origin = ray.Origin();
+    const glm::vec3 direction = ray.Direction();
+    float enter = minTime;
+    float exit = maxTime;
+    for (int i = 0; i < 3; ++i)
+    {
+      if (std::isnan(origin[i]) || std::isnan(direction[i]))
+        return {false, 0.0f, 0.0f};
+      if (direction[i] == 0.0f)
+      {
+        if (origin[i] < box.Min()[i] || origin[i] > box.Max()[i])
+          return {false, 0.0f, 0.0f};
+        continue;
+      }
+      const float inverse = 1.0f / direction[i];
+      const float t0 = (box.Min()[i] - origin[i]) * inverse;
+      const float t1 = (box.Max()[i] - origin[i]) * inverse;
+      enter = std::max(enter, std::min(t0, t1));
+      exit = std::min(exit, std::max(t0, t1));
+    }
+    return {enter <= exit, enter, exit};
+  }
+
+  float ReferenceTime(const Ray &ray, const AABB &box, float minTime, float maxTime)
+  {
+    const Span span = Reference(ray, box, minTime, maxTime);
+    return span.m_hit ? span.m_enter : s_infinity;
+  }
+
+  struct Interval
+  {
+    float m_min, m_max;
+  };
+
+  const Interval s_intervals[] = {{0.0f, 8.0f}, {-2.0f, 3.0f}, {0.0f, s_infinity}, {1.0f, 1.0f}};
+
+  void CheckSingle()
+  {
+    size_t mismatches = 0;
+    for (int i = 0; i < 20000; ++i)
+    {
+      const AABB box = RandomBox();
+      const Ray ray = RandomRay(true);
+      for (const Interval &interval : s_intervals)
+      {
+        const Span expected = Reference(ray, box, interval.m_min, interval.m_max);
+
+        AABB::HitRecord record;
+        const bool hit = box.Hit(ray, interval.m_min, interval.m_max, record) == Ray::HitType::Hit;
+        bool same = hit == expected.m_hit;
+        if (same && hit)
+          same = record.m_time == expected.m_enter && record.m_point == ray.At(expected.m_enter);
+
+        float minTime = interval.m_min;
+        float maxTime = interval.m_max;
+        const bool clipped = box.Clip(ray, minTime, maxTime);
+        same = same && clipped == expected.m_hit;
+        if (same && clipped)
+          same = minTime == expected.m_enter && maxTime == expected.m_exit;
+
+        mismatches += same ? 0 : 1;
+      }
+    }
+    CHECK(mismatches == 0);
+  }
+
+  std::vector<AABB::Path> Paths()
+  {
+    std::vector<AABB::Path> paths;
+    for (AABB::Path path : {AABB::Path::Scalar, AABB::Path::SSE41, AABB::Path::AVX})
+    {
+      if (static_cast<int>(path) <= static_cast<int>(AABB::BestPath()))
+        paths.push_back(path);
+    }
+    return paths;
+  }
+
+  // Counts up to a few full AVX blocks plus every tail length
+  const size_t s_counts[] = {0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 64, 67};
+
+  void CheckBoxes()
+  {
+    for (AABB::Path path : Paths())
+    {
+      size_t mismatches = 0;
+      for (int round = 0; round < 200; ++round)
+      {
+        for (size_t count : s_counts)
+        {
+          std::vector<AABB> boxes;
+          std::vector<float> coordinates[6];
+          for (size_t i = 0; i < count; ++i)
+          {
+            boxes.push_back(RandomBox());
+            for (int axis = 0; axis < 3; ++axis)
+            {
+              coordinates[axis].push_back(boxes.back().Min()[axis]);
+              coordinates[axis + 3].push_back(boxes.back().Max()[axis]);
+            }
+          }
+          const AABB::Boxes soa{coordinates[0], coordinates[1], coordinates[2], coordinates[3], coordinates[4], coordinates[5]};
+
+          const Ray ray = RandomRay(true);
+          const Interval &interval = s_intervals[round % std::size(s_intervals)];
+          std::vector<float> times(count, -1.0f);
+          const size_t hits = AABB::Hit(ray, interval.m_min, interval.m_max, soa, times, path);
+
+          size_t expectedHits = 0;
+          for (size_t i = 0; i < count; ++i)
+          {
+            const float expected = ReferenceTime(ray, boxes[i], interval.m_min, interval.m_max);
+            expectedHits += expected != s_infinity ? 1 : 0;
+            mismatches += times[i] == expected ? 0 : 1;
+          }
+          mismatches += hits == expectedHits ? 0 : 1;
+        }
+      }
+      if (!CHECK(mismatches == 0))
+        std::cerr << "boxes on path " << static_cast<int>(path) << ": " << mismatches << " mismatches" << std::endl;
+    }
+  }
+
+  void CheckRays()
+  {
+    for (AABB::Path path : Paths())
+    {
+      size_t mismatches = 0;
+      for (int round = 0; round < 200; ++round)
+      {
+        for (size_t count : s_counts)
+        {
+          std::vector<Ray> rays;
+          std::vector<float> coordinates[6];
+          for (size_t i = 0; i < count; ++i)
+          {
+            rays.push_back(RandomRay(true));
+            for (int axis = 0; axis < 3; ++axis)
+            {
+              coordinates[axis].push_back(rays.back().Origin()[axis]);
+              coordinates[axis + 3].push_back(rays.back().Direction()[axis]);
+            }
+          }
+          const AABB::Rays soa{coordinates[0], coordinates[1], coordinates[2], coordinates[3], coordinates[4], coordinates[5]};
+
+          const AABB box = RandomBox();
+          const Interval &interval = s_intervals[round % std::size(s_intervals)];
+          std::vector<float> times(count, -1.0f);
+          const size_t hits = box.Hit(soa, interval.m_min, interval.m_max, times, path);
+
+          size_t expectedHits = 0;
+          for (size_t i = 0; i < count; ++i)
+          {
+            const float expected = ReferenceTime(rays[i], box, interval.m_min, interval.m_max);
+            expectedHits += expected != s_infinity ? 1 : 0;
+            mismatches += times[i] == expected ? 0 : 1;
+          }
+          mismatches += hits == expectedHits ? 0 : 1;
+        }
+      }
+      if (!CHECK(mismatches == 0))
+        std::cerr << "rays on path " << static_cast<int>(path) << ": " << mismatches << " mismatches" << std::endl;
+    }
+  }
+
+  // A span shorter or longer than times is refused before anything is read
+  // or written (the kernels print why to std::cerr)
+  void CheckSizes()
+  {
+    const std::vector<float> eight(8, 1.0f), seven(7, 1.0f);
+    std::vector<float> times(8, -1.0f);
+    const Ray ray(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+    const AABB box(glm::vec3(-1.0f), glm::vec3(1.0f));
+    for (AABB::Path path : Paths())
+    {
+      const AABB::Boxes boxes{eight, eight, eight, eight, seven, eight};
+      CHECK(AABB::Hit(ray, 0.0f, 1.0f, boxes, times, path) == 0);
+      const AABB::Rays rays{eight, eight, eight, eight, eight, std::span<const float>(eight).first(4)};
+      CHECK(box.Hit(rays, 0.0f, 1.0f, times, path) == 0);
+      CHECK(std::all_of(times.begin(), times.end(), [](float time)
+                        { return time == -1.0f; }));
+    }
+  }
+}
+
+int main()
+{
+  CheckSingle();
+  CheckBoxes();
+  CheckRays();
+  CheckSizes();
+  return Check::Result("AABBTest");
+}
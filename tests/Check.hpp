@@ -0,0 +1,32 @@
+#pragma once
+#include <iostream>
+
+// Checks for the test programs: a failing CHECK prints the expression and
+// where it is, and Check::Result is what main returns
+namespace Check
+{
+  inline int s_failures = 0;
+
+  inline bool Report(bool passed, const char *expression, const char *file, int line)
+  {
+    if (!passed)
+    {
+      std::cerr << file << ":" << line << ": CHECK(" << expression << ") failed" << std::endl;
+      ++s_failures;
+    }
+    return passed;
+  }
+
+  inline int Result(const char *test)
+  {
+    if (s_failures == 0)
+    {
+      std::cout << test << ": passed" << std::endl;
+      return 0;
+    }
+    std::cout << test << ": " << s_failures << " checks failed" << std::endl;
+    return 1;
+  }
+}
+
+#define CHECK(condition) Check::Report(static_cast<bool>(condition), #condition, __FILE__, __LINE__)
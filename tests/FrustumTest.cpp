@@ -0,0 +1,177 @@
+#include "../include/Frustum.hpp"
+#include "../include/World.hpp"
+#include "Check.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <vector>
+
+// Planes taken from view-projection matrices whose frustum is known exactly,
+// then the boxes and world chunks those planes keep. Boxes touching a plane
+// count as inside.
+
+namespace
+{
+  constexpr size_t chunkSize = 16;
+  using World_t = World<chunkSize>;
+
+  bool Near(const glm::vec4 &plane, const glm::vec4 &expected)
+  {
+    // Relative to d, which is far from 1 for the far plane
+    const bool near = glm::length(plane - expected) < 1e-5f * std::max(1.0f, std::abs(expected.w));
+    if (!near)
+      std::cerr << "plane (" << plane.x << ", " << plane.y << ", " << plane.z << ", " << plane.w << "), expected ("
+                << expected.x << ", " << expected.y << ", " << expected.z << ", " << expected.w << ")" << std::endl;
+    return near;
+  }
+
+  // x in [-10, 10], y in [-5, 5], z in [-100, -1] in view space
+  glm::mat4 Box()
+  {
+    return glm::ortho(-10.0f, 10.0f, -5.0f, 5.0f, 1.0f, 100.0f);
+  }
+
+  void CheckPlanes()
+  {
+    using Side = Frustum::Side;
+    const Frustum box(Box());
+    CHECK(Near(box.Plane(Side::Left), glm::vec4(1.0f, 0.0f, 0.0f, 10.0f)));
+    CHECK(Near(box.Plane(Side::Right), glm::vec4(-1.0f, 0.0f, 0.0f, 10.0f)));
+    CHECK(Near(box.Plane(Side::Bottom), glm::vec4(0.0f, 1.0f, 0.0f, 5.0f)));
+    CHECK(Near(box.Plane(Side::Top), glm::vec4(0.0f, -1.0f, 0.0f, 5.0f)));
+    CHECK(Near(box.Plane(Side::Near), glm::vec4(0.0f, 0.0f, -1.0f, -1.0f)));
+    CHECK(Near(box.Plane(Side::Far), glm::vec4(0.0f, 0.0f, 1.0f, 100.0f)));
+
+    // 90 degrees and square: the side planes are |x| <= -z and |y| <= -z
+    const float s = 1.0f / std::sqrt(2.0f);
+    const Frustum cone(glm::perspective(glm::radians(90.0f), 1.0f, 1.0f, 101.0f));
+    CHECK(Near(cone.Plane(Side::Left), glm::vec4(s, 0.0f, -s, 0.0f)));
+    CHECK(Near(cone.Plane(Side::Right), glm::vec4(-s, 0.0f, -s, 0.0f)));
+    CHECK(Near(cone.Plane(Side::Bottom), glm::vec4(0.0f, s, -s, 0.0f)));
+    CHECK(Near(cone.Plane(Side::Top), glm::vec4(0.0f, -s, -s, 0.0f)));
+    CHECK(Near(cone.Plane(Side::Near), glm::vec4(0.0f, 0.0f, -1.0f, -1.0f)));
+    CHECK(Near(cone.Plane(Side::Far), glm::vec4(0.0f, 0.0f, 1.0f, 101.0f)));
+
+    // The same box seen from x = 5, so in world space x is in [-5, 15]
+    const glm::mat4 view = glm::lookAt(glm::vec3(5.0f, 0.0f, 0.0f), glm::vec3(5.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const Frustum moved(Box() * view);
+    CHECK(Near(moved.Plane(Side::Left), glm::vec4(1.0f, 0.0f, 0.0f, 5.0f)));
+    CHECK(Near(moved.Plane(Side::Right), glm::vec4(-1.0f, 0.0f, 0.0f, 15.0f)));
+    CHECK(std::abs(moved.Distance(Side::Left, glm::vec3(0.0f, 0.0f, -50.0f)) - 5.0f) < 1e-5f);
+    CHECK(std::abs(moved.Distance(Side::Far, glm::vec3(0.0f, 0.0f, -50.0f)) - 50.0f) < 1e-5f);
+  }
+
+  // Unit boxes at z = -50 with min x in [-15, 14] and min y in [-8, 7]:
+  // x from -11 (touching x = -10) to 10, y from -6 to 5, so 22 x 12 pass
+  void CheckBoxes()
+  {
+    const Frustum frustum(Box());
+    std::vector<float> coordinates[6];
+    std::vector<AABB> boxes;
+    for (int x = -15; x < 15; ++x)
+    {
+      for (int y = -8; y < 8; ++y)
+      {
+        boxes.emplace_back(glm::vec3(x, y, -50.0f), glm::vec3(x + 1, y + 1, -49.0f));
+        for (int axis = 0; axis < 3; ++axis)
+        {
+          coordinates[axis].push_back(boxes.back().Min()[axis]);
+          coordinates[axis + 3].push_back(boxes.back().Max()[axis]);
+        }
+      }
+    }
+    const AABB::Boxes soa{coordinates[0], coordinates[1], coordinates[2], coordinates[3], coordinates[4], coordinates[5]};
+
+    size_t single = 0;
+    for (const AABB &box : boxes)
+      single += frustum.Intersects(box) ? 1 : 0;
+    CHECK(single == 22 * 12);
+
+    for (AABB::Path path : {AABB::Path::Scalar, AABB::Path::SSE41, AABB::Path::AVX})
+    {
+      if (static_cast<int>(path) > static_cast<int>(AABB::BestPath()))
+        continue;
+      std::vector<uint8_t> visible(boxes.size(), 2);
+      CHECK(frustum.Intersects(soa, visible, path) == 22 * 12);
+      for (size_t i = 0; i < boxes.size(); ++i)
+        CHECK(visible[i] == (frustum.Intersects(boxes[i]) ? 1 : 0));
+    }
+
+    // Behind the camera and beyond the far plane
+    CHECK(!frustum.Intersects(AABB(glm::vec3(-1.0f, -1.0f, 0.0f), glm::vec3(1.0f, 1.0f, 0.5f))));
+    CHECK(!frustum.Intersects(AABB(glm::vec3(-1.0f, -1.0f, -102.0f), glm::vec3(1.0f, 1.0f, -101.0f))));
+    CHECK(frustum.Intersects(AABB(glm::vec3(-1.0f, -1.0f, -101.0f), glm::vec3(1.0f, 1.0f, -100.0f))));
+  }
+
+  // A visible span shorter or longer than the boxes, or box spans of
+  // different sizes, are refused before anything is read or written
+  void CheckSizes()
+  {
+    const Frustum frustum(Box());
+    const std::vector<float> ten(10, -50.0f), nine(9, -50.0f);
+    const AABB::Boxes boxes{ten, ten, ten, ten, ten, ten};
+    const AABB::Boxes uneven{ten, ten, ten, ten, nine, ten};
+    for (AABB::Path path : {AABB::Path::Scalar, AABB::Path::SSE41, AABB::Path::AVX})
+    {
+      if (static_cast<int>(path) > static_cast<int>(AABB::BestPath()))
+        continue;
+      std::vector<uint8_t> visible(16, 2);
+      CHECK(frustum.Intersects(boxes, std::span<uint8_t>(visible).first(9), path) == 0);
+      CHECK(frustum.Intersects(boxes, std::span<uint8_t>(visible).first(11), path) == 0);
+      CHECK(frustum.Intersects(uneven, std::span<uint8_t>(visible).first(10), path) == 0);
+      CHECK(std::all_of(visible.begin(), visible.end(), [](uint8_t flag)
+                        { return flag == 2; }));
+      CHECK(frustum.Intersects(boxes, std::span<uint8_t>(visible).first(10), path) == 0);
+      CHECK(std::all_of(visible.begin(), visible.begin() + 10, [](uint8_t flag)
+                        { return flag == 0; }));
+    }
+  }
+
+  // Looking straight down from y = 200 with an orthographic view of the
+  // given half width centred on x = z = 0; chunk borders are at multiples of 16
+  glm::mat4 FromAbove(float halfWidth, const glm::vec3 &target)
+  {
+    const glm::vec3 eye(0.0f, 200.0f, 0.0f);
+    const glm::mat4 view = glm::lookAt(eye, eye + target, glm::vec3(0.0f, 0.0f, -1.0f));
+    return glm::ortho(-halfWidth, halfWidth, -halfWidth, halfWidth, 1.0f, 400.0f) * view;
+  }
+
+  void CheckWorld()
+  {
+    World_t world(3, 64, 0, std::make_unique<FractalGenerator>(TerrainSettings(), 1337));
+    world.updateVisibleChunks(glm::vec3(8.0f, 12.0f, 8.0f));
+    world.Flush();
+    for (int x = -2; x < 2; ++x)
+    {
+      for (int z = -2; z < 2; ++z)
+        CHECK(world.ChunkAt(glm::ivec2(x, z)) != nullptr);
+    }
+
+    const glm::vec3 down(0.0f, -1.0f, 0.0f);
+    // [-8, 8] covers the four chunks around the origin, [-20, 20] the 4 x 4 around them
+    CHECK(world.Cull(FromAbove(8.0f, down)) == 4);
+    CHECK(world.VisibleCount() == 4);
+    CHECK(world.Cull(FromAbove(20.0f, down)) == 16);
+    CHECK(world.Cull(FromAbove(1000.0f, down)) == world.ChunkCount());
+    // Looking up from above every chunk sees none of them
+    CHECK(world.Cull(FromAbove(1000.0f, -down)) == 0);
+    CHECK(world.VisibleCount() == 0);
+
+    // A 90 degree camera at ground level looking along -z from the origin
+    // keeps only chunks that reach z < 0
+    const glm::mat4 camera = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 1000.0f) *
+                             glm::lookAt(glm::vec3(0.0f, 8.0f, 0.0f), glm::vec3(0.0f, 8.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    world.Cull(camera);
+    for (const World_t::Chunk_t *chunk : world.Visible())
+      CHECK(chunk->Bounds().Min().z < 0.0f);
+    CHECK(world.VisibleCount() > 0 && world.VisibleCount() < world.ChunkCount());
+  }
+}
+
+int main()
+{
+  CheckPlanes();
+  CheckBoxes();
+  CheckSizes();
+  CheckWorld();
+  return Check::Result("FrustumTest");
+}
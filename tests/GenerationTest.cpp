@@ -0,0 +1,134 @@
+#include "../include/World.hpp"
+#include "Check.hpp"
+#include <iomanip>
+#include <string>
+#include <vector>
+
+// Generated chunks hashed against values recorded once: a chunk must come
+// out the same in any generation order, on any number of threads and after
+// being dropped and regenerated. The values hold for builds without
+// -ffast-math or FMA contraction (-march=native on x86 may contract).
+
+namespace
+{
+  constexpr size_t chunkSize = 16;
+  using World_t = World<chunkSize>;
+  using Chunk_t = World_t::Chunk_t;
+
+  struct Golden
+  {
+    const char *m_generator;
+    glm::ivec2 m_coords;
+    uint64_t m_hash;
+  };
+
+  const std::vector<Golden> s_golden = {
+      {"heightmap 0", {0, 0}, 0x4513a4d2c491d05dull},
+      {"heightmap 0", {-1, -1}, 0x87d08f6d4bfef362ull},
+      {"heightmap 0", {5, -3}, 0x139a5e8f5ed479ceull},
+      {"heightmap 1337", {0, 0}, 0xba6e14c6ca20be4eull},
+      {"heightmap 1337", {31, 32}, 0x35c2fb93cf953224ull},
+      {"heightmap 1337", {-1000, 777}, 0x4e391f9b959ce3full},
+      {"fractal 1337", {0, 0}, 0x8188c6dc76e69f65ull},
+      {"fractal 1337", {1, 0}, 0xecf089cacc692cdbull},
+      {"fractal 1337", {-1, -1}, 0x8275e145c27cbbadull},
+      {"fractal 1337", {0, 2}, 0x6ffc728c1c045654ull},
+      {"fractal 1337", {31, 32}, 0x99ef532c94cfe909ull},
+      {"fractal 1337", {-1000, 777}, 0xcca9fc7f4ab7c7a2ull},
+      {"fractal 42", {0, 0}, 0x7745920ce3057d25ull},
+      {"fractal 42", {100000, -100000}, 0x477c50f3761a9a79ull},
+  };
+
+  std::unique_ptr<TerrainGenerator> MakeGenerator(const std::string &name)
+  {
+    if (name == "heightmap 0")
+      return std::make_unique<HeightmapGenerator>(0);
+    if (name == "heightmap 1337")
+      return std::make_unique<HeightmapGenerator>(1337);
+    if (name == "fractal 1337")
+      return std::make_unique<FractalGenerator>(TerrainSettings(), 1337);
+    return std::make_unique<FractalGenerator>(TerrainSettings(), 42);
+  }
+
+  uint64_t Generate(const TerrainGenerator &generator, const glm::ivec2 &coords)
+  {
+    const glm::ivec2 origin = coords * static_cast<int>(chunkSize);
+    Chunk_t chunk{glm::vec2(origin)};
+    chunk.Generate(generator, origin.x, origin.y);
+    return chunk.Hash();
+  }
+
+  bool Matches(const Golden &golden, uint64_t hash)
+  {
+    if (hash == golden.m_hash)
+      return true;
+    std::cerr << golden.m_generator << " chunk " << golden.m_coords.x << ", " << golden.m_coords.y
+              << ": hash 0x" << std::hex << hash << std::dec << std::endl;
+    return false;
+  }
+
+  // Each chunk on its own, then all of them again backwards with one
+  // generator object shared by every chunk
+  void CheckStandalone()
+  {
+    for (const Golden &golden : s_golden)
+      CHECK(Matches(golden, Generate(*MakeGenerator(golden.m_generator), golden.m_coords)));
+
+    const auto shared = MakeGenerator("fractal 1337");
+    for (auto it = s_golden.rbegin(); it != s_golden.rend(); ++it)
+    {
+      if (std::string(it->m_generator) == "fractal 1337")
+        CHECK(Matches(*it, Generate(*shared, it->m_coords)));
+    }
+  }
+
+  void CheckLoaded(const World_t &world)
+  {
+    for (const Golden &golden : s_golden)
+    {
+      if (std::string(golden.m_generator) != "fractal 1337")
+        continue;
+      if (const Chunk_t *chunk = world.ChunkAt(golden.m_coords))
+        CHECK(Matches(golden, chunk->Hash()));
+    }
+  }
+
+  glm::vec3 Center(const glm::ivec2 &coords)
+  {
+    return glm::vec3(coords.x * static_cast<float>(chunkSize) + 8.0f, 12.0f, coords.y * static_cast<float>(chunkSize) + 8.0f);
+  }
+
+  // The world on 0 (inline), 1 and 4 workers, reaching the origin straight
+  // away or after loading around another chunk first, then regenerating
+  // everything after the camera went away and came back
+  void CheckWorld()
+  {
+    for (size_t threads : {0, 1, 4})
+    {
+      for (const glm::ivec2 &first : {glm::ivec2(0, 0), glm::ivec2(3, -2)})
+      {
+        World_t world(2, 64, threads, MakeGenerator("fractal 1337"));
+        world.updateVisibleChunks(Center(first));
+        world.Flush();
+        world.updateVisibleChunks(Center({0, 0}));
+        world.Flush();
+        CHECK(world.ChunkAt(glm::ivec2(0, 2)) != nullptr);
+        CheckLoaded(world);
+
+        world.updateVisibleChunks(Center({20, 20}));
+        world.Flush();
+        CHECK(world.ChunkAt(glm::ivec2(0, 0)) == nullptr);
+        world.updateVisibleChunks(Center({0, 0}));
+        world.Flush();
+        CheckLoaded(world);
+      }
+    }
+  }
+}
+
+int main()
+{
+  CheckStandalone();
+  CheckWorld();
+  return Check::Result("GenerationTest");
+}
@@ -0,0 +1,77 @@
+#include "../include/LodCache.hpp"
+#include "Check.hpp"
+#include <set>
+
+// LodCache bookkeeping without a GL context: empty meshes never create GL
+// objects, and a mesh over the budget is refused before it is uploaded.
+// Chunks that were only ever drawn from the cache must leave it when they
+// unload, as WorldRenderer sweeps it with Retain.
+
+namespace
+{
+  ChunkMesh Quad()
+  {
+    ChunkMesh mesh;
+    mesh.m_vertices.resize(4);
+    mesh.m_indices = {0, 1, 2, 0, 2, 3};
+    return mesh;
+  }
+
+  void CheckRetain()
+  {
+    LodCache cache(3);
+    std::set<std::pair<int, int>> loaded;
+    for (int x = 0; x < 4; ++x)
+    {
+      for (int z = 0; z < 4; ++z)
+      {
+        loaded.insert({x, z});
+        for (int level = 1; level < 3; ++level)
+          CHECK(cache.Insert(LodCache::Key{glm::ivec2(x, z), level}, 1, ChunkMesh()) != nullptr);
+      }
+    }
+    CHECK(cache.Size() == 32);
+
+    // Połowa chunków zwolniona; nigdy nie miały pełnej siatki
+    for (int z = 0; z < 2; ++z)
+    {
+      for (int x = 0; x < 4; ++x)
+        loaded.erase({x, z});
+    }
+    const auto keep = [&loaded](const glm::ivec2 &coords)
+    { return loaded.count({coords.x, coords.y}) != 0; };
+    cache.NextFrame();
+    cache.Retain(keep);
+    CHECK(cache.Size() == 16);
+    CHECK(cache.Find(LodCache::Key{glm::ivec2(0, 0), 1}, 1) == nullptr);
+    CHECK(cache.Find(LodCache::Key{glm::ivec2(0, 3), 2}, 1) != nullptr);
+
+    // Meshes drawn this frame go as well once their chunk is gone
+    loaded.clear();
+    cache.Retain(keep);
+    CHECK(cache.Size() == 0);
+    CHECK(cache.MemoryUsage() == 0);
+  }
+
+  void CheckRefusals()
+  {
+    LodCache cache(3, 0);
+    const LodCache::Key key{glm::ivec2(5, -2), 1};
+    CHECK(cache.Insert(key, 7, Quad()) == nullptr);
+    CHECK(cache.Refused(key, 7));
+    CHECK(!cache.Refused(key, 8));
+
+    CHECK(cache.Insert(key, 7, Quad()) == nullptr);
+    cache.Retain([](const glm::ivec2 &)
+                 { return false; });
+    CHECK(!cache.Refused(key, 7));
+    CHECK(cache.Size() == 0);
+  }
+}
+
+int main()
+{
+  CheckRetain();
+  CheckRefusals();
+  return Check::Result("LodCacheTest");
+}
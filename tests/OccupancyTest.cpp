@@ -0,0 +1,92 @@
+#include "../include/Occupancy.hpp"
+#include "Check.hpp"
+#include <random>
+
+// Occupancy::Trace, which jumps over empty bricks and regions with
+// VoxelRay::Leave, against a VoxelRay stepped through every cell. Chunk
+// shapes with one region, several regions and partial bricks; rays start
+// inside and run to the chunk's side, some along an axis.
+
+namespace
+{
+  std::mt19937 s_random(1337);
+
+  float Uniform(float min, float max)
+  {
+    return std::uniform_real_distribution<float>(min, max)(s_random);
+  }
+
+  template <uint8_t Depth, uint8_t Width, uint8_t Height>
+  void CheckTrace(float fill, bool terrain)
+  {
+    using Occupancy_t = Occupancy<Depth, Width, Height>;
+    std::array<Cube::Type, Depth * Width * Height> blocks{};
+    size_t index = 0;
+    for (int y = 0; y < Height; ++y)
+    {
+      for (int x = 0; x < Width; ++x)
+      {
+        for (int z = 0; z < Depth; ++z, ++index)
+        {
+          const bool solid = terrain ? y < 5 + (x * z) % 7 : Uniform(0.0f, 1.0f) < fill;
+          blocks[index] = solid ? Cube::Type::Stone : Cube::Type::None;
+        }
+      }
+    }
+    Occupancy_t occupancy;
+    occupancy.Assign(blocks);
+
+    const glm::vec3 size(Width, Height, Depth);
+    const glm::ivec3 last(Width - 1, Height - 1, Depth - 1);
+    size_t mismatches = 0;
+    for (int round = 0; round < 20000; ++round)
+    {
+      const glm::vec3 origin(Uniform(0.0f, size.x), Uniform(0.0f, size.y), Uniform(0.0f, size.z));
+      glm::vec3 direction(Uniform(-1.0f, 1.0f), Uniform(-1.0f, 1.0f), Uniform(-1.0f, 1.0f));
+      if (round % 5 == 0)
+        direction[round % 3] = 0.0f;
+      const Ray ray(origin, direction);
+      Ray::time_t maxTime = std::numeric_limits<Ray::time_t>::infinity();
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        if (direction[axis] != 0.0f)
+          maxTime = std::min(maxTime, ((direction[axis] > 0.0f ? size[axis] : 0.0f) - origin[axis]) / direction[axis]);
+      }
+
+      typename Occupancy_t::TraceHit hit;
+      const bool traced = occupancy.Trace(ray, 0.0f, maxTime, hit);
+
+      VoxelRay walk(ray, 0.0f, maxTime, glm::ivec3(0), last);
+      bool found = false;
+      do
+      {
+        const glm::ivec3 cell = walk.Cell();
+        if (glm::all(glm::greaterThanEqual(cell, glm::ivec3(0))) && glm::all(glm::lessThanEqual(cell, last)) &&
+            occupancy.IsSolid(cell.x, cell.y, cell.z))
+        {
+          found = true;
+          break;
+        }
+      } while (walk.Step());
+
+      if (traced != found)
+        ++mismatches;
+      else if (found && (hit.m_cell != walk.Cell() || hit.m_face != walk.EnteredFace() || std::abs(hit.m_time - walk.Time()) > 1e-3f))
+        ++mismatches;
+    }
+    if (!CHECK(mismatches == 0))
+      std::cerr << static_cast<int>(Width) << "x" << static_cast<int>(Height) << "x" << static_cast<int>(Depth) << ": " << mismatches << " mismatches" << std::endl;
+  }
+}
+
+int main()
+{
+  for (bool terrain : {false, true})
+  {
+    CheckTrace<16, 16, 16>(0.02f, terrain);
+    CheckTrace<16, 16, 64>(0.001f, terrain);
+    CheckTrace<10, 12, 40>(0.003f, terrain);
+  }
+  CheckTrace<16, 16, 16>(0.9f, false);
+  return Check::Result("OccupancyTest");
+}
@@ -0,0 +1,123 @@
+#include "../include/PerlinNoise.hpp"
+#include "Check.hpp"
+#include <bit>
+#include <cmath>
+#include <random>
+#include <vector>
+
+// PerlinNoise::AtBatch on every path the CPU has against At, bit for bit.
+// Coordinates are negative as well as positive, past the 256 wrap of the
+// permutation table, on whole numbers and just beside them; counts cover
+// every tail length after full SSE and AVX2 blocks, and the spans start at
+// an offset so the kernels see unaligned data.
+
+namespace
+{
+  std::mt19937 s_random(1337);
+
+  float Uniform(float min, float max)
+  {
+    return std::uniform_real_distribution<float>(min, max)(s_random);
+  }
+
+  float Coordinate()
+  {
+    switch (std::uniform_int_distribution<int>(0, 3)(s_random))
+    {
+    case 0:
+      return static_cast<float>(std::uniform_int_distribution<int>(-300, 300)(s_random));
+    case 1:
+      return std::nextafter(static_cast<float>(std::uniform_int_distribution<int>(-300, 300)(s_random)), Uniform(-1.0f, 1.0f));
+    case 2:
+      return Uniform(-4.0f, 4.0f);
+    default:
+      return Uniform(-1000.0f, 1000.0f);
+    }
+  }
+
+  std::vector<PerlinNoise::Path> Paths()
+  {
+    std::vector<PerlinNoise::Path> paths;
+    for (PerlinNoise::Path path : {PerlinNoise::Path::Scalar, PerlinNoise::Path::SSE41, PerlinNoise::Path::AVX2})
+    {
+      if (static_cast<int>(path) <= static_cast<int>(PerlinNoise::BestPath()))
+        paths.push_back(path);
+    }
+    return paths;
+  }
+
+  const size_t s_counts[] = {0, 1, 3, 4, 5, 7, 8, 9, 12, 15, 16, 17, 31, 64, 67};
+
+  void CheckBatch(const PerlinNoise &noise, uint64_t seed)
+  {
+    for (PerlinNoise::Path path : Paths())
+    {
+      size_t mismatches = 0;
+      for (int round = 0; round < 100; ++round)
+      {
+        for (size_t count : s_counts)
+        {
+          const size_t offset = round % 3;
+          std::vector<float> xs(offset + count), ys(offset + count), zs(offset + count);
+          for (size_t i = offset; i < offset + count; ++i)
+          {
+            xs[i] = Coordinate();
+            ys[i] = Coordinate();
+            zs[i] = Coordinate();
+          }
+          std::vector<float> out(offset + count, -2.0f);
+          noise.AtBatch(std::span(xs).subspan(offset), std::span(ys).subspan(offset), std::span(zs).subspan(offset), std::span(out).subspan(offset), path);
+
+          for (size_t i = offset; i < offset + count; ++i)
+          {
+            const float expected = noise.At(glm::vec3(xs[i], ys[i], zs[i]));
+            mismatches += std::bit_cast<uint32_t>(out[i]) == std::bit_cast<uint32_t>(expected) ? 0 : 1;
+          }
+          for (size_t i = 0; i < offset; ++i)
+            mismatches += out[i] == -2.0f ? 0 : 1;
+        }
+      }
+      if (!CHECK(mismatches == 0))
+        std::cerr << "seed " << seed << " on path " << static_cast<int>(path) << ": " << mismatches << " mismatches" << std::endl;
+    }
+  }
+
+  // Only as many samples as the shortest span, nothing written past it
+  void CheckShortSpans(const PerlinNoise &noise)
+  {
+    for (PerlinNoise::Path path : Paths())
+    {
+      std::vector<float> xs(19), ys(19), zs(13);
+      for (size_t i = 0; i < xs.size(); ++i)
+      {
+        xs[i] = Coordinate();
+        ys[i] = Coordinate();
+        if (i < zs.size())
+          zs[i] = Coordinate();
+      }
+      std::vector<float> out(19, -2.0f);
+      noise.AtBatch(xs, ys, zs, out, path);
+
+      size_t mismatches = 0;
+      for (size_t i = 0; i < out.size(); ++i)
+      {
+        if (i < zs.size())
+          mismatches += out[i] == noise.At(glm::vec3(xs[i], ys[i], zs[i])) ? 0 : 1;
+        else
+          mismatches += out[i] == -2.0f ? 0 : 1;
+      }
+      CHECK(mismatches == 0);
+    }
+  }
+}
+
+int main()
+{
+  for (uint64_t seed : {0, 1, 42, 1337})
+  {
+    const PerlinNoise noise(seed);
+    CheckBatch(noise, seed);
+    CheckShortSpans(noise);
+  }
+  return Check::Result("PerlinNoiseTest");
+}